@@ -0,0 +1,1318 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CFG_IMPLEMENTATION
+#define CFG_IO_URING
+#include "cfg.h"
+
+// Benchmark suite for cfg.h, configs are generated deterministically in the shape of `example.cfg`
+//
+// load        throughput of buffer, stream and file loaders
+// memory      allocations of loaded, compacted and image configs and walks over them
+// shared      children attaching the image of the config and checking its tree
+// fork_reads  pages of the tree dirtied by reads in a forked child, must be 0
+// lookup      latency of cfg_get_* at different context sizes
+// layout      name lookup in one large struct against a linear strcmp scan
+// intern      loading of repeated string values with and without interning
+// mutate      updates, inserts and removals in a context of 1000 variables
+// overlay     path lookups through three layers: first, cached and after a change
+// env         variables overridden through cfg_overlay_push_env against getenv
+// clone       per-tenant configs made by parsing against cloning of one base
+// files       many small files loaded one by one against cfg_load_files
+// include     files sharing an @include, inline and with cold and warm include cache
+//
+// Results are written as JSON to stdout or to the file passed with `-o`.
+
+typedef struct {
+    size_t keys;         // Number of variables in global context
+    size_t depth;        // Maximum nesting depth of structs
+    size_t fanout;       // Number of variables in every nested struct
+    size_t array_len;    // Number of elements in arrays and lists
+    size_t string_len;   // Length of generated string values
+    double comments;     // Probability of a comment before a variable
+    uint64_t seed;
+    size_t iterations;   // Repetitions of every measurement, best one is reported
+} Bench_Params;
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} Bench_Buffer;
+
+typedef struct {
+    const char *api;
+    double seconds;
+} Bench_Load_Result;
+
+static uint64_t bench_rng_state;
+static volatile uintptr_t bench_sink;
+
+static uint64_t bench_rand(void)
+{
+    // xorshift64*, deterministic for a given seed
+    bench_rng_state ^= bench_rng_state >> 12;
+    bench_rng_state ^= bench_rng_state << 25;
+    bench_rng_state ^= bench_rng_state >> 27;
+    return bench_rng_state * 2685821657736338717ULL;
+}
+
+static double bench_rand_unit(void)
+{
+    return (double)(bench_rand() >> 11) / (double)(1ULL << 53);
+}
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void bench_buffer_append(Bench_Buffer *buf, const char *str, size_t len)
+{
+    if (buf->len + len + 1 > buf->cap) {
+        while (buf->len + len + 1 > buf->cap) {
+            buf->cap = buf->cap ? buf->cap * 2 : 4096;
+        }
+        buf->data = realloc(buf->data, buf->cap);
+        if (!buf->data) {
+            fprintf(stderr, "bench: failed to allocate memory\n");
+            exit(1);
+        }
+    }
+    memcpy(buf->data + buf->len, str, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+}
+
+static void bench_buffer_printf(Bench_Buffer *buf, const char *fmt, ...)
+{
+    char tmp[256];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(tmp, sizeof(tmp), fmt, args);
+    va_end(args);
+    bench_buffer_append(buf, tmp, (size_t)len < sizeof(tmp) ? (size_t)len : sizeof(tmp) - 1);
+}
+
+static void bench_indent(Bench_Buffer *buf, size_t level)
+{
+    for (size_t i = 0; i < level; ++i) {
+        bench_buffer_append(buf, "    ", 4);
+    }
+}
+
+static void bench_gen_string(Bench_Buffer *buf, const Bench_Params *p)
+{
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789 -_./";
+    bench_buffer_append(buf, "\"", 1);
+    for (size_t i = 0; i < p->string_len; ++i) {
+        char ch = alphabet[bench_rand() % (sizeof(alphabet) - 1)];
+        bench_buffer_append(buf, &ch, 1);
+    }
+    bench_buffer_append(buf, "\"", 1);
+}
+
+static void bench_gen_scalar(Bench_Buffer *buf, const Bench_Params *p, int kind)
+{
+    switch (kind) {
+    case 0:
+        bench_buffer_printf(buf, "%u", (unsigned)(bench_rand() % 100000));
+        break;
+    case 1:
+        bench_buffer_printf(buf, "%u.%03u", (unsigned)(bench_rand() % 10000), (unsigned)(bench_rand() % 1000));
+        break;
+    case 2:
+        bench_buffer_printf(buf, "%s", bench_rand() & 1 ? "true" : "false");
+        break;
+    default:
+        bench_gen_string(buf, p);
+        break;
+    }
+}
+
+static void bench_gen_comment(Bench_Buffer *buf, const Bench_Params *p, size_t level)
+{
+    if (bench_rand_unit() >= p->comments) return;
+
+    bench_indent(buf, level);
+    if (bench_rand() & 1) {
+        bench_buffer_append(buf, "// Single line comment about the next variable\n", 47);
+    } else {
+        bench_buffer_append(buf, "/*\n", 3);
+        bench_indent(buf, level);
+        bench_buffer_append(buf, " * Multiline comment, number = 55;\n", 35);
+        bench_indent(buf, level);
+        bench_buffer_append(buf, " */\n", 4);
+    }
+}
+
+static void bench_gen_context(Bench_Buffer *buf, const Bench_Params *p, size_t keys, size_t depth, size_t level)
+{
+    for (size_t i = 0; i < keys; ++i) {
+        bench_gen_comment(buf, p, level);
+        bench_indent(buf, level);
+
+        // Every 8th variable is a nested struct while depth allows it,
+        // the rest is spread between scalars, arrays and lists
+        int kind = (int)(bench_rand() % 6);
+        if (depth > 0 && i % 8 == 7) kind = 6;
+
+        switch (kind) {
+        case 4:
+            bench_buffer_printf(buf, "array_%zu = [", i);
+            for (size_t j = 0; j < p->array_len; ++j) {
+                if (j > 0) bench_buffer_append(buf, ", ", 2);
+                bench_gen_scalar(buf, p, 0);
+            }
+            bench_buffer_append(buf, "];\n", 3);
+            break;
+        case 5:
+            bench_buffer_printf(buf, "list_%zu = (", i);
+            for (size_t j = 0; j < p->array_len; ++j) {
+                if (j > 0) bench_buffer_append(buf, ", ", 2);
+                bench_gen_scalar(buf, p, (int)(j % 4));
+            }
+            bench_buffer_append(buf, ");\n", 3);
+            break;
+        case 6:
+            bench_buffer_printf(buf, "struct_%zu = {\n", i);
+            bench_gen_context(buf, p, p->fanout, depth - 1, level + 1);
+            bench_indent(buf, level);
+            bench_buffer_append(buf, "};\n", 3);
+            break;
+        default:
+            bench_buffer_printf(buf, "key_%zu = ", i);
+            bench_gen_scalar(buf, p, kind);
+            bench_buffer_append(buf, ";\n", 2);
+            break;
+        }
+    }
+}
+
+static Bench_Buffer bench_generate(const Bench_Params *p)
+{
+    Bench_Buffer buf = {0};
+    bench_rng_state = p->seed ? p->seed : 1;
+    bench_gen_context(&buf, p, p->keys, p->depth, 0);
+    return buf;
+}
+
+static size_t bench_count_nodes(Cfg_Variable *ctx)
+{
+    size_t count = 0;
+    size_t len = cfg_get_context_len(ctx);
+    for (size_t i = 0; i < len; ++i) {
+        count++;
+        switch (cfg_get_type_elem(ctx, i)) {
+        case CFG_TYPE_ARRAY:
+            count += bench_count_nodes(cfg_get_array_elem(ctx, i));
+            break;
+        case CFG_TYPE_LIST:
+            count += bench_count_nodes(cfg_get_list_elem(ctx, i));
+            break;
+        case CFG_TYPE_STRUCT:
+            count += bench_count_nodes(cfg_get_struct_elem(ctx, i));
+            break;
+        default:
+            break;
+        }
+    }
+    return count;
+}
+
+static size_t bench_count_image_nodes(Cfg_Node ctx)
+{
+    size_t count = 0;
+    size_t len = cfg_node_len(ctx);
+    for (size_t i = 0; i < len; ++i) {
+        Cfg_Node node = cfg_node_elem(ctx, i);
+        count++;
+        if (cfg_node_type(node) & (CFG_TYPE_ARRAY | CFG_TYPE_LIST | CFG_TYPE_STRUCT)) {
+            count += bench_count_image_nodes(node);
+        }
+    }
+    return count;
+}
+
+// Walks config tree or image tree if `image` is not NULL
+static double bench_time_walk(Cfg_Config *cfg, const Cfg_Image *image, size_t iterations)
+{
+    double best = 0.0;
+    for (size_t i = 0; i < iterations; ++i) {
+        double start = bench_now();
+        if (image) {
+            bench_sink = bench_count_image_nodes(cfg_image_root(image));
+        } else {
+            bench_sink = bench_count_nodes(cfg_global_context(cfg));
+        }
+        double elapsed = bench_now() - start;
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+static Cfg_Config *bench_load(int api, Bench_Buffer *buf, const char *path)
+{
+    Cfg_Config *cfg = cfg_config_init();
+    Cfg_Error_Type err = CFG_ERROR_NONE;
+
+    switch (api) {
+    case 0:
+        err = cfg_load_buffer(cfg, buf->data);
+        break;
+    case 1: {
+        FILE *stream = fmemopen(buf->data, buf->len, "r");
+        if (!stream) {
+            fprintf(stderr, "bench: fmemopen failed\n");
+            exit(1);
+        }
+        err = cfg_load_stream(cfg, stream);
+        fclose(stream);
+        break;
+    }
+    default:
+        err = cfg_load_file(cfg, path);
+        break;
+    }
+
+    if (err != CFG_ERROR_NONE) {
+        fprintf(stderr, "bench: failed to load generated config: %s\n", cfg_err_message(cfg));
+        exit(1);
+    }
+
+    return cfg;
+}
+
+static double bench_time_load(int api, Bench_Buffer *buf, const char *path, size_t iterations)
+{
+    double best = 0.0;
+    for (size_t i = 0; i < iterations; ++i) {
+        double start = bench_now();
+        Cfg_Config *cfg = bench_load(api, buf, path);
+        double elapsed = bench_now() - start;
+        cfg_config_deinit(cfg);
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+// Lookup benchmark context: `size` variables named k<i> with types cycling
+// through int, double, bool, string and struct.
+static Bench_Buffer bench_generate_flat(size_t size)
+{
+    Bench_Buffer buf = {0};
+    for (size_t i = 0; i < size; ++i) {
+        switch (i % 5) {
+        case 0:
+            bench_buffer_printf(&buf, "k%zu = %zu;\n", i, i);
+            break;
+        case 1:
+            bench_buffer_printf(&buf, "k%zu = %zu.5;\n", i, i);
+            break;
+        case 2:
+            bench_buffer_printf(&buf, "k%zu = %s;\n", i, i & 1 ? "true" : "false");
+            break;
+        case 3:
+            bench_buffer_printf(&buf, "k%zu = \"value %zu\";\n", i, i);
+            break;
+        default:
+            bench_buffer_printf(&buf, "k%zu = { a = 1; };\n", i);
+            break;
+        }
+    }
+    return buf;
+}
+
+
+static double bench_time_lookup(Cfg_Variable *ctx, size_t size, int getter, size_t iterations)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (getter == 5 || (int)(i % 5) == getter) count++;
+    }
+    if (count == 0) return 0.0;
+
+    char (*names)[32] = malloc(sizeof(*names) * count);
+    size_t n = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (getter == 5) {
+            snprintf(names[n++], 32, "missing%zu", i);
+        } else if ((int)(i % 5) == getter) {
+            snprintf(names[n++], 32, "k%zu", i);
+        }
+    }
+
+    // Shuffle so lookups do not walk the context in definition order
+    bench_rng_state = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = n - 1; i > 0; --i) {
+        size_t j = bench_rand() % (i + 1);
+        char tmp[32];
+        memcpy(tmp, names[i], 32);
+        memcpy(names[i], names[j], 32);
+        memcpy(names[j], tmp, 32);
+    }
+
+    // Calibrate the number of rounds so one measurement takes ~20ms,
+    // large contexts would take forever with a fixed lookup count
+    size_t rounds = 1;
+    double best = 0.0;
+    for (size_t it = 0; it <= iterations; ++it) {
+        uintptr_t acc = 0;
+        double start = bench_now();
+        for (size_t r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < n; ++i) {
+                switch (getter) {
+                case 0:
+                    acc += (uintptr_t)cfg_get_int(ctx, names[i]);
+                    break;
+                case 1:
+                    acc += (uintptr_t)cfg_get_double(ctx, names[i]);
+                    break;
+                case 2:
+                    acc += (uintptr_t)cfg_get_bool(ctx, names[i]);
+                    break;
+                case 3:
+                    acc += (uintptr_t)cfg_get_string(ctx, names[i]);
+                    break;
+                case 4:
+                    acc += (uintptr_t)cfg_get_struct(ctx, names[i]);
+                    break;
+                default:
+                    acc += (uintptr_t)cfg_get_int(ctx, names[i]);
+                    break;
+                }
+            }
+        }
+        double elapsed = bench_now() - start;
+        bench_sink = acc;
+        if (it == 0) {
+            double per_round = elapsed > 0.0 ? elapsed : 1e-9;
+            rounds = (size_t)(0.02 / per_round) + 1;
+            continue;
+        }
+        if (it == 1 || elapsed < best) best = elapsed;
+    }
+
+    free(names);
+    return best * 1e9 / (double)(rounds * n);
+}
+
+// Struct with `size` int variables named like real settings,
+// names share a long prefix so string comparisons are not free
+static Bench_Buffer bench_generate_struct(size_t size)
+{
+    Bench_Buffer buf = {0};
+    bench_buffer_append(&buf, "layout = {\n", 11);
+    for (size_t i = 0; i < size; ++i) {
+        bench_buffer_printf(&buf, "    setting_%zu = %zu;\n", i, i);
+    }
+    bench_buffer_append(&buf, "};\n", 3);
+    return buf;
+}
+
+// Name lookup before hashes of names were stored next to variables:
+// strcmp against every variable of context
+static Cfg_Variable *bench_linear_find(Cfg_Variable *ctx, const char *name)
+{
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        if (ctx->vars[i].name != NULL && strcmp(name, ctx->vars[i].name) == 0) {
+            return &ctx->vars[i];
+        }
+    }
+    return NULL;
+}
+
+// `linear` selects bench_linear_find instead of cfg_get_type,
+// `miss` looks up names which are not defined
+static double bench_time_layout(Cfg_Variable *ctx, size_t size, bool linear, bool miss, size_t iterations)
+{
+    size_t n = size < 1024 ? size : 1024;
+    char (*names)[32] = malloc(sizeof(*names) * n);
+    bench_rng_state = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < n; ++i) {
+        snprintf(names[i], 32, "setting_%zu%s", (size_t)(bench_rand() % size), miss ? "_" : "");
+    }
+
+    size_t rounds = 1;
+    double best = 0.0;
+    for (size_t it = 0; it <= iterations; ++it) {
+        uintptr_t acc = 0;
+        double start = bench_now();
+        for (size_t r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < n; ++i) {
+                if (linear) {
+                    acc += (uintptr_t)bench_linear_find(ctx, names[i]);
+                } else {
+                    acc += (uintptr_t)cfg_get_type(ctx, names[i]);
+                }
+            }
+        }
+        double elapsed = bench_now() - start;
+        bench_sink = acc;
+        if (it == 0) {
+            double per_round = elapsed > 0.0 ? elapsed : 1e-9;
+            rounds = (size_t)(0.02 / per_round) + 1;
+            continue;
+        }
+        if (it == 1 || elapsed < best) best = elapsed;
+    }
+
+    free(names);
+    return best * 1e9 / (double)(rounds * n);
+}
+
+// Config where string values are picked from a few hostnames, modes and paths
+static Bench_Buffer bench_generate_repetitive(size_t size)
+{
+    static const char *values[] = {
+        "db-primary.internal.example.com", "db-replica.internal.example.com",
+        "cache-01.internal.example.com", "read-write-with-fallback",
+        "/var/lib/service/data/storage", "/var/log/service/current.log",
+        "/etc/service/certificates/server.pem", "https://auth.example.com/oauth2/token",
+    };
+    size_t values_len = sizeof(values) / sizeof(values[0]);
+    Bench_Buffer buf = {0};
+    bench_rng_state = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < size; ++i) {
+        bench_buffer_printf(&buf, "service_%zu = { host = \"%s\"; log = \"%s\"; };\n", i,
+                            values[bench_rand() % values_len], values[bench_rand() % values_len]);
+    }
+    return buf;
+}
+
+// Loads `buf` with or without interning, memory usage of the last load is stored in `mem`
+static double bench_time_intern(Bench_Buffer *buf, bool intern, size_t iterations, Cfg_MemInfo *mem)
+{
+    double best = 0.0;
+    for (size_t i = 0; i < iterations; ++i) {
+        Cfg_Config *cfg = cfg_config_init();
+        cfg_config_intern_values(cfg, intern);
+        double start = bench_now();
+        if (cfg_load_buffer(cfg, buf->data) != CFG_ERROR_NONE) {
+            fprintf(stderr, "bench: failed to load generated config: %s\n", cfg_err_message(cfg));
+            exit(1);
+        }
+        double elapsed = bench_now() - start;
+        cfg_memory_usage(cfg, mem);
+        cfg_config_deinit(cfg);
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+// Mutation of flat config of `size` variables (see `bench_generate_flat`), ns per operation:
+// `op` 0 sets every int (in place), 1 sets every string (in place), 2 inserts `size` variables
+// into new struct, 3 removes them from the end. Allocations made by the operation are stored in `allocations`
+static double bench_time_mutate(Cfg_Config *cfg, size_t size, int op, size_t *allocations)
+{
+    Cfg_Variable *ctx = cfg_global_context(cfg);
+    Cfg_Variable *inserted = cfg_get_struct(ctx, "inserted");
+    Cfg_MemInfo before, after;
+    char name[32], value[32];
+    cfg_memory_usage(cfg, &before);
+    double start = bench_now();
+    for (size_t i = 0; i < size; ++i) {
+        Cfg_Error_Type err = CFG_ERROR_NONE;
+        switch (op) {
+        case 0:
+            if (i % 5 != 0) continue;
+            snprintf(name, sizeof(name), "k%zu", i);
+            err = cfg_set_int(cfg, ctx, name, (int)(i + 1));
+            break;
+        case 1:
+            if (i % 5 != 3) continue;
+            snprintf(name, sizeof(name), "k%zu", i);
+            snprintf(value, sizeof(value), "VALUE %zu", i);
+            err = cfg_set_string(cfg, ctx, name, value);
+            break;
+        case 2:
+            snprintf(name, sizeof(name), "n%zu", i);
+            snprintf(value, sizeof(value), "%zu", i);
+            if (!cfg_insert(cfg, inserted, CFG_TYPE_INT, name, value)) err = cfg_err_type(cfg);
+            break;
+        default:
+            err = cfg_remove_elem(cfg, inserted, cfg_get_context_len(inserted) - 1);
+            break;
+        }
+        if (err != CFG_ERROR_NONE) {
+            fprintf(stderr, "bench: failed to modify config: %s\n", cfg_err_message(cfg));
+            exit(1);
+        }
+    }
+    double elapsed = bench_now() - start;
+    cfg_memory_usage(cfg, &after);
+    *allocations = after.allocations - before.allocations;
+    return elapsed * 1e9 / (op < 2 ? size / 5 : size);
+}
+
+// Per-tenant configs: base config with one override (`struct_7.tenant_id`), made by parsing `buf` for
+// every tenant or by `cfg_config_clone` of one parsed base. All clones are kept alive,
+// parsed configs are freed one by one (memory of each is summed). Returns ns per tenant,
+// bytes per tenant (base included for clones) are stored in `bytes`
+static double bench_time_tenants(Bench_Buffer *buf, size_t tenants, bool clone, size_t *bytes)
+{
+    Cfg_Config *base = clone ? bench_load(0, buf, NULL) : NULL;
+    Cfg_Config **cfgs = malloc(sizeof(Cfg_Config *) * tenants);
+    Cfg_MemInfo mem;
+    size_t total = 0;
+    if (base) {
+        cfg_memory_usage(base, &mem);
+        total += mem.total;
+    }
+    double start = bench_now();
+    for (size_t i = 0; i < tenants; ++i) {
+        Cfg_Config *cfg = clone ? cfg_config_clone(base) : bench_load(0, buf, NULL);
+        Cfg_Variable *ctx = cfg ? cfg_get_struct(cfg_global_context(cfg), "struct_7") : NULL;
+        if (!ctx || cfg_set_int(cfg, ctx, "tenant_id", (int)i) != CFG_ERROR_NONE) {
+            fprintf(stderr, "bench: failed to make tenant config\n");
+            exit(1);
+        }
+        cfg_memory_usage(cfg, &mem);
+        total += mem.total;
+        if (clone) {
+            cfgs[i] = cfg;
+        } else {
+            cfg_config_deinit(cfg);
+        }
+    }
+    double elapsed = bench_now() - start;
+    if (clone) {
+        for (size_t i = 0; i < tenants; ++i) cfg_config_deinit(cfgs[i]);
+        cfg_config_deinit(base);
+    }
+    free(cfgs);
+    *bytes = total / tenants;
+    return elapsed * 1e9 / tenants;
+}
+
+// Paths of variables of global context and of structs inside it (`struct_7.key_0`), at most `max`
+static size_t bench_overlay_paths(Cfg_Variable *ctx, char **paths, size_t max)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < cfg_get_context_len(ctx) && len < max; ++i) {
+        char *name = cfg_get_name(ctx, i);
+        Cfg_Variable *inner = cfg_get_struct_elem(ctx, i);
+        for (size_t j = 0; inner != NULL && j < cfg_get_context_len(inner) && len < max; ++j) {
+            size_t size = strlen(name) + strlen(cfg_get_name(inner, j)) + 2;
+            paths[len] = malloc(size);
+            snprintf(paths[len++], size, "%s.%s", name, cfg_get_name(inner, j));
+        }
+        if (len < max) paths[len++] = strdup(name);
+    }
+    return len;
+}
+
+// Overlay of `layers` configs over generated config, ns per cfg_overlay_find:
+// `pass` 0 resolves and caches every path, 1 reads cached paths, 2 revalidates them after
+// top layer was modified
+static double bench_time_overlay(Cfg_Overlay *overlay, Cfg_Config *top, char **paths, size_t len, int pass)
+{
+    if (pass == 2 && cfg_set_int(top, cfg_global_context(top), "generation", 1) != CFG_ERROR_NONE) {
+        fprintf(stderr, "bench: failed to modify config: %s\n", cfg_err_message(top));
+        exit(1);
+    }
+    double start = bench_now();
+    for (size_t i = 0; i < len; ++i) {
+        bench_sink += (uintptr_t)cfg_overlay_find(overlay, paths[i]);
+    }
+    return (bench_now() - start) * 1e9 / len;
+}
+
+// Reads int variables `k<i>` (every 5th of `size`) overridden by environment variables
+// `BENCH_K<i>`, through environment layer of overlay or with getenv and strtol, ns per read
+static double bench_time_env(Cfg_Overlay *overlay, size_t size, bool use_getenv, size_t iterations)
+{
+    char name[32];
+    size_t reads = 0;
+    double start = bench_now();
+    for (size_t it = 0; it < iterations; ++it) {
+        for (size_t i = 0; i < size; i += 5) {
+            if (use_getenv) {
+                snprintf(name, sizeof(name), "BENCH_K%zu", i);
+                const char *value = getenv(name);
+                bench_sink += value ? (uintptr_t)strtol(value, NULL, 10) : 0;
+            } else {
+                snprintf(name, sizeof(name), "k%zu", i);
+                bench_sink += (uintptr_t)cfg_overlay_get_int(overlay, name);
+            }
+            reads++;
+        }
+    }
+    return (bench_now() - start) * 1e9 / reads;
+}
+
+// Loads `count` files with cfg_load_file one by one or with one cfg_load_files call
+// All configs are kept until every file is loaded, like at startup of a service
+static double bench_time_files(const char *const *paths, size_t count, bool batched, size_t iterations)
+{
+    Cfg_Config **cfgs = malloc(sizeof(Cfg_Config *) * count);
+    double best = 0.0;
+    for (size_t i = 0; i < iterations; ++i) {
+        for (size_t f = 0; f < count; ++f) cfgs[f] = cfg_config_init();
+        double start = bench_now();
+        size_t loaded = 0;
+        if (batched) {
+            loaded = cfg_load_files(cfgs, paths, count);
+        } else {
+            for (size_t f = 0; f < count; ++f) {
+                if (cfg_load_file(cfgs[f], paths[f]) == CFG_ERROR_NONE) loaded++;
+            }
+        }
+        double elapsed = bench_now() - start;
+        for (size_t f = 0; f < count; ++f) cfg_config_deinit(cfgs[f]);
+        if (loaded != count) {
+            fprintf(stderr, "bench: failed to load %zu of %zu files\n", count - loaded, count);
+            exit(1);
+        }
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    free(cfgs);
+    return best;
+}
+
+// Loads `count` files with cfg_load_files
+// Include cache is cleared before every iteration if `cold`, so a shared included file
+// is parsed once per iteration, otherwise it is parsed only by the first one
+static double bench_time_include(const char *const *paths, size_t count, bool cold, size_t iterations)
+{
+    Cfg_Config **cfgs = malloc(sizeof(Cfg_Config *) * count);
+    double best = 0.0;
+    cfg_include_cache_clear();
+    for (size_t i = 0; i < iterations + 1; ++i) {
+        if (cold) cfg_include_cache_clear();
+        for (size_t f = 0; f < count; ++f) cfgs[f] = cfg_config_init();
+        double start = bench_now();
+        size_t loaded = cfg_load_files(cfgs, paths, count);
+        double elapsed = bench_now() - start;
+        if (loaded != count) {
+            for (size_t f = 0; f < count; ++f) {
+                if (cfg_err_type(cfgs[f]) != CFG_ERROR_NONE) {
+                    fprintf(stderr, "bench: failed to load `%s`: %s\n", paths[f], cfg_err_message(cfgs[f]));
+                    exit(1);
+                }
+            }
+        }
+        for (size_t f = 0; f < count; ++f) cfg_config_deinit(cfgs[f]);
+        // First warm iteration fills the cache
+        if (i == 0 && !cold) continue;
+        if (best == 0.0 || elapsed < best) best = elapsed;
+    }
+    cfg_include_cache_clear();
+    free(cfgs);
+    return best;
+}
+
+// Forks `children` processes which attach image from `fd` and check number of its nodes
+// Returns number of children which saw the same tree
+static int bench_shared_children(int fd, size_t nodes, int children)
+{
+    for (int c = 0; c < children; ++c) {
+        pid_t pid = fork();
+        if (pid < 0) break;
+        if (pid == 0) {
+            Cfg_Image *image = cfg_attach_shared(fd);
+            bool ok = image && bench_count_image_nodes(cfg_image_root(image)) == nodes;
+            cfg_image_free(image);
+            _exit(ok ? 0 : 1);
+        }
+    }
+
+    int ok = 0;
+    int status;
+    while (wait(&status) > 0) {
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) ok++;
+    }
+    return ok;
+}
+
+// Arena for config of `fork_reads` section, so private dirty memory of the tree alone can be measured
+// Region is mapped between two inaccessible pages and is never merged with other mappings
+typedef struct {
+    char *base;
+    size_t size;
+    size_t used;
+} Bench_Arena;
+
+static void *bench_arena_alloc(void *ctx, size_t size)
+{
+    Bench_Arena *arena = ctx;
+    size = (size + 15) & ~(size_t)15;
+    if (arena->size - arena->used < size) return NULL;
+    void *ptr = arena->base + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+static void *bench_arena_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    Bench_Arena *arena = ctx;
+    // Last block grows in place
+    if (ptr && (char *)ptr + ((old_size + 15) & ~(size_t)15) == arena->base + arena->used) {
+        arena->used = (size_t)((char *)ptr - arena->base);
+        if (bench_arena_alloc(ctx, new_size)) return ptr;
+        arena->used += (old_size + 15) & ~(size_t)15;
+        return NULL;
+    }
+    void *new_ptr = bench_arena_alloc(ctx, new_size);
+    if (new_ptr && ptr) memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    return new_ptr;
+}
+
+static void bench_arena_free(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    (void)ptr;
+    (void)size;
+}
+
+static bool bench_arena_init(Bench_Arena *arena, size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) / page * page;
+    char *map = mmap(NULL, size + 2 * page, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (map == MAP_FAILED) return false;
+    if (mprotect(map + page, size, PROT_READ | PROT_WRITE) != 0) {
+        munmap(map, size + 2 * page);
+        return false;
+    }
+    arena->base = map + page;
+    arena->size = size;
+    arena->used = 0;
+    return true;
+}
+
+static void bench_arena_deinit(Bench_Arena *arena)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    munmap(arena->base - page, arena->size + 2 * page);
+}
+
+// Private dirty memory in kB of the mapping which starts at `base` from /proc/self/smaps,
+// -1 if it is not available
+static long bench_private_dirty_kb(const void *base)
+{
+    FILE *smaps = fopen("/proc/self/smaps", "r");
+    if (!smaps) return -1;
+    char line[512];
+    bool found = false;
+    long kb = -1;
+    while (fgets(line, sizeof(line), smaps)) {
+        unsigned long start;
+        char dash;
+        if (sscanf(line, "%lx%c", &start, &dash) == 2 && dash == '-') {
+            found = start == (unsigned long)(uintptr_t)base;
+        } else if (found && strncmp(line, "Private_Dirty:", strlen("Private_Dirty:")) == 0) {
+            kb = strtol(line + strlen("Private_Dirty:"), NULL, 10);
+            break;
+        }
+    }
+    fclose(smaps);
+    return kb;
+}
+
+// Reads every variable through cfg_get_<type_name>_safe and one missing name per struct
+static size_t bench_read_safe(Cfg_Variable *ctx, bool named)
+{
+    size_t count = 0;
+    size_t len = cfg_get_context_len(ctx);
+    int int_value;
+    double double_value;
+    bool bool_value;
+    char *string_value;
+    Cfg_Variable *inner;
+    if (named) count += cfg_get_int_safe(ctx, "bench_missing_name", &int_value) != CFG_ERROR_NONE;
+    for (size_t i = 0; i < len; ++i) {
+        const char *name = cfg_get_name(ctx, i);
+        Cfg_Type type = cfg_get_type_elem(ctx, i);
+        if (!named) {
+            // Elements of arrays/lists have no names, only inner structs are read by name
+            if (type == CFG_TYPE_STRUCT) count += bench_read_safe(cfg_get_struct_elem(ctx, i), true);
+            if (type == CFG_TYPE_ARRAY) count += bench_read_safe(cfg_get_array_elem(ctx, i), false);
+            if (type == CFG_TYPE_LIST) count += bench_read_safe(cfg_get_list_elem(ctx, i), false);
+            continue;
+        }
+        switch (type) {
+        case CFG_TYPE_INT: count += cfg_get_int_safe(ctx, name, &int_value) == CFG_ERROR_NONE; break;
+        case CFG_TYPE_DOUBLE: count += cfg_get_double_safe(ctx, name, &double_value) == CFG_ERROR_NONE; break;
+        case CFG_TYPE_BOOL: count += cfg_get_bool_safe(ctx, name, &bool_value) == CFG_ERROR_NONE; break;
+        case CFG_TYPE_STRING: count += cfg_get_string_safe(ctx, name, &string_value) == CFG_ERROR_NONE; break;
+        case CFG_TYPE_ARRAY:
+            if (cfg_get_array_safe(ctx, name, &inner) == CFG_ERROR_NONE) count += bench_read_safe(inner, false);
+            break;
+        case CFG_TYPE_LIST:
+            if (cfg_get_list_safe(ctx, name, &inner) == CFG_ERROR_NONE) count += bench_read_safe(inner, false);
+            break;
+        case CFG_TYPE_STRUCT:
+            if (cfg_get_struct_safe(ctx, name, &inner) == CFG_ERROR_NONE) count += bench_read_safe(inner, true);
+            break;
+        default:
+            break;
+        }
+    }
+    return count;
+}
+
+// Forks a process which reads whole config through the safe getters and reports growth
+// of private dirty memory of arena with the tree in kB (pages copied from parent), -1 if it can not be measured
+static long bench_fork_reads(Cfg_Config *cfg, const Bench_Arena *arena)
+{
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        close(fds[0]);
+        long before = bench_private_dirty_kb(arena->base);
+        bench_sink = bench_read_safe(cfg_global_context(cfg), true);
+        long after = bench_private_dirty_kb(arena->base);
+        long dirtied = before < 0 || after < 0 ? -1 : after - before;
+        ssize_t written = write(fds[1], &dirtied, sizeof(dirtied));
+        _exit(written == sizeof(dirtied) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    long dirtied = -1;
+    if (read(fds[0], &dirtied, sizeof(dirtied)) != sizeof(dirtied)) dirtied = -1;
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+    return dirtied;
+}
+
+static void bench_usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --keys N         variables in global context (default 2000)\n"
+        "  --depth N        nesting depth of structs (default 3)\n"
+        "  --fanout N       variables in every nested struct (default 8)\n"
+        "  --array-len N    elements in arrays and lists (default 8)\n"
+        "  --string-len N   length of string values (default 24)\n"
+        "  --comments P     probability of a comment before a variable (default 0.2)\n"
+        "  --seed N         generator seed (default 1)\n"
+        "  --iterations N   repetitions of every measurement (default 5)\n"
+        "  --dump           print generated config to stdout and exit\n"
+        "  -o PATH          write JSON results to PATH instead of stdout\n",
+        prog);
+}
+
+int main(int argc, char **argv)
+{
+    Bench_Params p = {
+        .keys = 2000,
+        .depth = 3,
+        .fanout = 8,
+        .array_len = 8,
+        .string_len = 24,
+        .comments = 0.2,
+        .seed = 1,
+        .iterations = 5,
+    };
+    const char *out_path = NULL;
+    bool dump = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--dump") == 0) {
+            dump = true;
+            continue;
+        }
+        if (!val) {
+            bench_usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--keys") == 0) p.keys = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--depth") == 0) p.depth = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--fanout") == 0) p.fanout = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--array-len") == 0) p.array_len = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--string-len") == 0) p.string_len = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--comments") == 0) p.comments = strtod(val, NULL);
+        else if (strcmp(arg, "--seed") == 0) p.seed = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--iterations") == 0) p.iterations = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "-o") == 0) out_path = val;
+        else {
+            bench_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (p.iterations == 0) p.iterations = 1;
+
+    Bench_Buffer buf = bench_generate(&p);
+    if (dump) {
+        fwrite(buf.data, 1, buf.len, stdout);
+        free(buf.data);
+        return 0;
+    }
+
+    // Names followed by `=` without spaces, every loader must keep the `=` token
+    char unspaced[] = "a=1; s={b=2;};";
+    Cfg_Config *unspaced_cfg = cfg_config_init();
+    if (cfg_load_buffer(unspaced_cfg, unspaced) != CFG_ERROR_NONE ||
+        cfg_get_int(cfg_get_struct(cfg_global_context(unspaced_cfg), "s"), "b") != 2) {
+        fprintf(stderr, "bench: failed to load `a=1;`: %s\n", cfg_err_message(unspaced_cfg));
+        return 1;
+    }
+    cfg_config_deinit(unspaced_cfg);
+
+    char path[] = "/tmp/cfg_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, buf.data, buf.len) != (ssize_t)buf.len) {
+        fprintf(stderr, "bench: failed to write temporary file\n");
+        return 1;
+    }
+    close(fd);
+
+    Cfg_Config *cfg = bench_load(0, &buf, path);
+    size_t nodes = bench_count_nodes(cfg_global_context(cfg));
+
+    // Memory footprint and full tree walk before and after compaction
+    Cfg_MemInfo loaded_mem, compacted_mem;
+    cfg_memory_usage(cfg, &loaded_mem);
+    double walk_loaded = bench_time_walk(cfg, NULL, p.iterations);
+    double compact_start = bench_now();
+    if (cfg_config_compact(cfg) != CFG_ERROR_NONE) {
+        fprintf(stderr, "bench: %s\n", cfg_err_message(cfg));
+        return 1;
+    }
+    double compact_seconds = bench_now() - compact_start;
+    cfg_memory_usage(cfg, &compacted_mem);
+    double walk_compacted = bench_time_walk(cfg, NULL, p.iterations);
+    Cfg_Image *image = cfg_image_build(cfg);
+    if (!image) {
+        fprintf(stderr, "bench: %s\n", cfg_err_message(cfg));
+        return 1;
+    }
+    double walk_image = bench_time_walk(NULL, image, p.iterations);
+    size_t image_bytes = image->size;
+
+    // Image in shared memory: parent attaches it too, forked children verify the tree, the run fails if any of them does not
+    int shared_children = 4;
+    int shared_fd = cfg_image_share(image);
+    cfg_image_free(image);
+    if (shared_fd < 0) {
+        fprintf(stderr, "bench: failed to share image\n");
+        return 1;
+    }
+    double attach_start = bench_now();
+    Cfg_Image *shared = cfg_attach_shared(shared_fd);
+    double attach_seconds = bench_now() - attach_start;
+    if (!shared) {
+        fprintf(stderr, "bench: failed to attach shared image\n");
+        return 1;
+    }
+    double walk_shared = bench_time_walk(NULL, shared, p.iterations);
+    int shared_ok = bench_shared_children(shared_fd, bench_count_image_nodes(cfg_image_root(shared)), shared_children);
+    cfg_image_free(shared);
+    close(shared_fd);
+    cfg_config_deinit(cfg);
+
+    // Reads in a forked process must not copy pages of the tree, the run fails otherwise
+    Bench_Arena arena;
+    if (!bench_arena_init(&arena, buf.len * 64 + ((size_t)1 << 20))) {
+        fprintf(stderr, "bench: failed to map arena\n");
+        return 1;
+    }
+    Cfg_Allocator arena_alloc = {bench_arena_alloc, bench_arena_realloc, bench_arena_free, &arena};
+    cfg = cfg_config_init_allocator(&arena_alloc);
+    if (!cfg || cfg_load_buffer(cfg, buf.data) != CFG_ERROR_NONE) {
+        fprintf(stderr, "bench: failed to load generated config into arena\n");
+        return 1;
+    }
+    Cfg_MemInfo fork_mem;
+    cfg_memory_usage(cfg, &fork_mem);
+    long fork_dirtied_kb = bench_fork_reads(cfg, &arena);
+    cfg_config_deinit(cfg);
+    bench_arena_deinit(&arena);
+
+    static const char *load_apis[] = {"cfg_load_buffer", "cfg_load_stream", "cfg_load_file"};
+    Bench_Load_Result load[3];
+    for (int api = 0; api < 3; ++api) {
+        load[api].api = load_apis[api];
+        load[api].seconds = bench_time_load(api, &buf, path, p.iterations);
+    }
+    unlink(path);
+
+    FILE *out = stdout;
+    if (out_path) {
+        out = fopen(out_path, "w");
+        if (!out) {
+            fprintf(stderr, "bench: failed to open `%s`\n", out_path);
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"params\": {\"keys\": %zu, \"depth\": %zu, \"fanout\": %zu, \"array_len\": %zu, "
+                 "\"string_len\": %zu, \"comments\": %.3f, \"seed\": %llu, \"iterations\": %zu},\n",
+            p.keys, p.depth, p.fanout, p.array_len, p.string_len, p.comments,
+            (unsigned long long)p.seed, p.iterations);
+    fprintf(out, "  \"input\": {\"bytes\": %zu, \"nodes\": %zu},\n", buf.len, nodes);
+
+    fprintf(out, "  \"load\": [\n");
+    for (int api = 0; api < 3; ++api) {
+        fprintf(out, "    {\"api\": \"%s\", \"seconds\": %.9f, \"mb_per_s\": %.3f, \"nodes_per_s\": %.0f}%s\n",
+                load[api].api, load[api].seconds,
+                (double)buf.len / load[api].seconds / 1e6,
+                (double)nodes / load[api].seconds,
+                api + 1 < 3 ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+
+    fprintf(out, "  \"memory\": {\"loaded_bytes\": %zu, \"loaded_allocations\": %zu, "
+                 "\"compacted_bytes\": %zu, \"compacted_allocations\": %zu, \"compact_seconds\": %.9f, "
+                 "\"image_bytes\": %zu, \"walk_ns_per_node_loaded\": %.2f, \"walk_ns_per_node_compacted\": %.2f, "
+                 "\"walk_ns_per_node_image\": %.2f},\n",
+            loaded_mem.total, loaded_mem.allocations,
+            compacted_mem.total, compacted_mem.allocations, compact_seconds, image_bytes,
+            walk_loaded * 1e9 / (double)nodes, walk_compacted * 1e9 / (double)nodes,
+            walk_image * 1e9 / (double)nodes);
+    fprintf(out, "  \"shared\": {\"children\": %d, \"children_ok\": %d, \"attach_seconds\": %.9f, "
+                 "\"walk_ns_per_node_shared\": %.2f},\n",
+            shared_children, shared_ok, attach_seconds, walk_shared * 1e9 / (double)nodes);
+    fprintf(out, "  \"fork_reads\": {\"tree_kb\": %zu, \"dirtied_kb\": %ld},\n", fork_mem.total / 1024, fork_dirtied_kb);
+
+    static const char *getters[] = {
+        "cfg_get_int", "cfg_get_double", "cfg_get_bool",
+        "cfg_get_string", "cfg_get_struct", "cfg_get_int (miss)",
+    };
+    static const size_t sizes[] = {8, 64, 512, 4096};
+    size_t sizes_len = sizeof(sizes) / sizeof(sizes[0]);
+    size_t getters_len = sizeof(getters) / sizeof(getters[0]);
+
+    fprintf(out, "  \"lookup\": [\n");
+    for (size_t s = 0; s < sizes_len; ++s) {
+        Bench_Buffer flat = bench_generate_flat(sizes[s]);
+        Cfg_Config *flat_cfg = bench_load(0, &flat, NULL);
+        for (size_t g = 0; g < getters_len; ++g) {
+            double ns = bench_time_lookup(cfg_global_context(flat_cfg), sizes[s], (int)g, p.iterations);
+            fprintf(out, "    {\"api\": \"%s\", \"context_size\": %zu, \"ns_per_lookup\": %.2f}%s\n",
+                    getters[g], sizes[s], ns,
+                    s + 1 < sizes_len || g + 1 < getters_len ? "," : "");
+        }
+        cfg_config_deinit(flat_cfg);
+        free(flat.data);
+    }
+    fprintf(out, "  ],\n");
+
+    // Large struct: hashed lookup of the library against plain strcmp scan
+    size_t layout_size = 10000;
+    Bench_Buffer layout = bench_generate_struct(layout_size);
+    Cfg_Config *layout_cfg = bench_load(0, &layout, NULL);
+    Cfg_Variable *layout_ctx = cfg_get_struct(cfg_global_context(layout_cfg), "layout");
+    static const char *layout_apis[] = {"cfg_get_type", "linear strcmp"};
+    fprintf(out, "  \"layout\": [\n");
+    for (int linear = 0; linear < 2; ++linear) {
+        for (int miss = 0; miss < 2; ++miss) {
+            double ns = bench_time_layout(layout_ctx, layout_size, linear, miss, p.iterations);
+            fprintf(out, "    {\"api\": \"%s%s\", \"context_size\": %zu, \"ns_per_lookup\": %.2f}%s\n",
+                    layout_apis[linear], miss ? " (miss)" : "", layout_size, ns,
+                    linear + miss < 2 ? "," : "");
+        }
+    }
+    fprintf(out, "  ],\n");
+    cfg_config_deinit(layout_cfg);
+    free(layout.data);
+
+    // Repeated string values with and without interning
+    Bench_Buffer repetitive = bench_generate_repetitive(p.keys);
+    fprintf(out, "  \"intern\": [\n");
+    for (int intern = 0; intern < 2; ++intern) {
+        Cfg_MemInfo mem;
+        double seconds = bench_time_intern(&repetitive, intern, p.iterations, &mem);
+        fprintf(out, "    {\"interning\": %s, \"seconds\": %.9f, \"bytes\": %zu, \"allocations\": %zu, "
+                     "\"values_bytes\": %zu, \"interned_bytes\": %zu, \"intern_saved_bytes\": %zu}%s\n",
+                intern ? "true" : "false", seconds, mem.total, mem.allocations,
+                mem.values, mem.interned, mem.intern_saved, intern ? "" : ",");
+    }
+    fprintf(out, "  ],\n");
+    free(repetitive.data);
+
+    // In place updates, inserts and removals
+    size_t mutate_size = 1000;
+    static const char *mutate_apis[] = {"cfg_set_int", "cfg_set_string", "cfg_insert", "cfg_remove_elem"};
+    Bench_Buffer mutate = bench_generate_flat(mutate_size);
+    Cfg_Config *mutate_cfg = bench_load(0, &mutate, NULL);
+    if (!cfg_insert(mutate_cfg, cfg_global_context(mutate_cfg), CFG_TYPE_STRUCT, "inserted", NULL)) {
+        fprintf(stderr, "bench: failed to modify config: %s\n", cfg_err_message(mutate_cfg));
+        return 1;
+    }
+    fprintf(out, "  \"mutate\": [\n");
+    for (int op = 0; op < 4; ++op) {
+        size_t allocations;
+        double ns = bench_time_mutate(mutate_cfg, mutate_size, op, &allocations);
+        fprintf(out, "    {\"api\": \"%s\", \"context_size\": %zu, \"ns_per_op\": %.2f, \"allocations\": %zu}%s\n",
+                mutate_apis[op], mutate_size, ns, allocations, op < 3 ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+    cfg_config_deinit(mutate_cfg);
+    free(mutate.data);
+
+    // Overlay: defaults (generated config), file with a few overrides and empty top layer
+    size_t overlay_max = 20000;
+    char **overlay_paths = malloc(sizeof(char *) * overlay_max);
+    Cfg_Config *overlay_layers[3] = {bench_load(0, &buf, NULL), cfg_config_init(), cfg_config_init()};
+    Cfg_Overlay *overlay = cfg_overlay_init();
+    size_t overlay_len = bench_overlay_paths(cfg_global_context(overlay_layers[0]), overlay_paths, overlay_max);
+    if (cfg_load_buffer(overlay_layers[1], (char[]){"key_0 = 1; struct_7 = { key_0 = 2; };"}) != CFG_ERROR_NONE) {
+        fprintf(stderr, "bench: failed to load overlay layer: %s\n", cfg_err_message(overlay_layers[1]));
+        return 1;
+    }
+    for (int l = 0; l < 3; ++l) cfg_overlay_push(overlay, overlay_layers[l]);
+    static const char *overlay_passes[] = {"resolve", "cached", "revalidate"};
+    fprintf(out, "  \"overlay\": [\n");
+    for (int pass = 0; pass < 3; ++pass) {
+        double ns = bench_time_overlay(overlay, overlay_layers[2], overlay_paths, overlay_len, pass);
+        fprintf(out, "    {\"pass\": \"%s\", \"layers\": 3, \"paths\": %zu, \"ns_per_lookup\": %.2f}%s\n",
+                overlay_passes[pass], overlay_len, ns, pass < 2 ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+    cfg_overlay_deinit(overlay);
+    for (int l = 0; l < 3; ++l) cfg_config_deinit(overlay_layers[l]);
+    for (size_t i = 0; i < overlay_len; ++i) free(overlay_paths[i]);
+    free(overlay_paths);
+
+    // Environment overrides: layer built by cfg_overlay_push_env against getenv per read
+    size_t env_size = 1000;
+    Bench_Buffer env_input = bench_generate_flat(env_size);
+    Cfg_Config *env_base = bench_load(0, &env_input, NULL);
+    Cfg_Config *env_layer = cfg_config_init();
+    Cfg_Overlay *env_overlay = cfg_overlay_init();
+    for (size_t i = 0; i < env_size; i += 5) {
+        char name[32], value[32];
+        snprintf(name, sizeof(name), "BENCH_K%zu", i);
+        snprintf(value, sizeof(value), "%zu", i + 1);
+        setenv(name, value, 1);
+    }
+    cfg_overlay_push(env_overlay, env_base);
+    double env_start = bench_now();
+    if (cfg_overlay_push_env(env_overlay, env_layer, "BENCH_", NULL) != CFG_ERROR_NONE) {
+        fprintf(stderr, "bench: failed to load environment: %s\n", cfg_err_message(env_layer));
+        return 1;
+    }
+    double env_load = bench_now() - env_start;
+    double env_overlay_ns = bench_time_env(env_overlay, env_size, false, p.iterations);
+    double env_getenv_ns = bench_time_env(env_overlay, env_size, true, p.iterations);
+    fprintf(out, "  \"env\": {\"variables\": %zu, \"push_env_seconds\": %.9f, \"overlay_ns_per_read\": %.2f, "
+                 "\"getenv_ns_per_read\": %.2f},\n",
+            env_size / 5, env_load, env_overlay_ns, env_getenv_ns);
+    for (size_t i = 0; i < env_size; i += 5) {
+        char name[32];
+        snprintf(name, sizeof(name), "BENCH_K%zu", i);
+        unsetenv(name);
+    }
+    cfg_overlay_deinit(env_overlay);
+    cfg_config_deinit(env_layer);
+    cfg_config_deinit(env_base);
+    free(env_input.data);
+
+    // Per-tenant configs: parse for every tenant against clones of one base
+    static const size_t tenants[] = {20, 1000};
+    fprintf(out, "  \"clone\": [\n");
+    for (int clone = 0; clone < 2; ++clone) {
+        size_t bytes;
+        double ns = bench_time_tenants(&buf, tenants[clone], clone, &bytes);
+        fprintf(out, "    {\"api\": \"%s\", \"tenants\": %zu, \"ns_per_tenant\": %.2f, \"bytes_per_tenant\": %zu}%s\n",
+                clone ? "cfg_config_clone" : "cfg_load_buffer", tenants[clone], ns, bytes, clone ? "" : ",");
+    }
+    fprintf(out, "  ],\n");
+
+    // Many small files: cfg_load_file one by one against cfg_load_files
+    size_t files_count = 2000;
+    char dir[] = "/tmp/cfg_bench_files_XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "bench: failed to create temporary directory\n");
+        return 1;
+    }
+    char **files = malloc(sizeof(char *) * files_count);
+    Bench_Buffer small = bench_generate_flat(16);
+    for (size_t f = 0; f < files_count; ++f) {
+        files[f] = malloc(sizeof(dir) + 32);
+        snprintf(files[f], sizeof(dir) + 32, "%s/%zu.cfg", dir, f);
+        FILE *file = fopen(files[f], "w");
+        if (!file) {
+            fprintf(stderr, "bench: failed to create `%s`\n", files[f]);
+            return 1;
+        }
+        fwrite(small.data, 1, small.len, file);
+        fclose(file);
+    }
+    double files_single = bench_time_files((const char *const *)files, files_count, false, p.iterations);
+    double files_batched = bench_time_files((const char *const *)files, files_count, true, p.iterations);
+    fprintf(out, "  \"files\": {\"count\": %zu, \"bytes_per_file\": %zu, \"cfg_load_file_seconds\": %.9f, "
+                 "\"cfg_load_files_seconds\": %.9f},\n",
+            files_count, small.len, files_single, files_batched);
+
+    // Top-level files with shared part copied into each of them against including it:
+    // include cache cleared before every load (shared file is parsed once per load) and kept
+    size_t includes_count = 200;
+    char shared_path[sizeof(dir) + 32];
+    snprintf(shared_path, sizeof(shared_path), "%s/shared.cfg", dir);
+    Bench_Buffer shared_input = bench_generate_flat(2000);
+    FILE *shared_file = fopen(shared_path, "w");
+    if (!shared_file) {
+        fprintf(stderr, "bench: failed to create `%s`\n", shared_path);
+        return 1;
+    }
+    fwrite(shared_input.data, 1, shared_input.len, shared_file);
+    fclose(shared_file);
+    for (size_t f = 0; f < includes_count; ++f) {
+        FILE *file = fopen(files[f], "w");
+        if (!file) {
+            fprintf(stderr, "bench: failed to create `%s`\n", files[f]);
+            return 1;
+        }
+        fwrite(shared_input.data, 1, shared_input.len, file);
+        fprintf(file, "tenant_id = %zu;\n", f);
+        fclose(file);
+    }
+    double include_inline = bench_time_include((const char *const *)files, includes_count, true, p.iterations);
+    for (size_t f = 0; f < includes_count; ++f) {
+        FILE *file = fopen(files[f], "w");
+        if (!file) {
+            fprintf(stderr, "bench: failed to create `%s`\n", files[f]);
+            return 1;
+        }
+        fprintf(file, "@include \"shared.cfg\";\ntenant_id = %zu;\n", f);
+        fclose(file);
+    }
+    double include_cold = bench_time_include((const char *const *)files, includes_count, true, p.iterations);
+    double include_warm = bench_time_include((const char *const *)files, includes_count, false, p.iterations);
+    fprintf(out, "  \"include\": {\"files\": %zu, \"shared_bytes\": %zu, \"inline_seconds\": %.9f, "
+                 "\"cold_cache_seconds\": %.9f, \"warm_cache_seconds\": %.9f}\n",
+            includes_count, shared_input.len, include_inline, include_cold, include_warm);
+    unlink(shared_path);
+    free(shared_input.data);
+
+    for (size_t f = 0; f < files_count; ++f) {
+        unlink(files[f]);
+        free(files[f]);
+    }
+    rmdir(dir);
+    free(files);
+    free(small.data);
+    fprintf(out, "}\n");
+
+    if (out != stdout) fclose(out);
+    free(buf.data);
+
+    if (shared_ok != shared_children) {
+        fprintf(stderr, "bench: %d of %d forked processes saw broken shared image\n", shared_children - shared_ok, shared_children);
+        return 1;
+    }
+    if (fork_dirtied_kb != 0) {
+        fprintf(stderr, "bench: reads in forked process dirtied %ld kB of the tree\n", fork_dirtied_kb);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,456 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define CFG_HPP_ASYNC
+#include "cfg.hpp"
+
+// Benchmark of cfg.hpp against direct calls of the C API
+//
+// Loads flat contexts of different sizes and measures the same lookups
+// through cfg_get_* and through cfg::Node::get<T>, compares lookups by
+// literal names with and without compile-time hashing (`_k`), then walks
+// a nested config with both APIs, sums an int array through cfg_get_*_elem
+// and through cfg::Range, loads with malloc and with a monotonic memory resource,
+// and loads a settings struct through cfg_get_* and through CFG_BIND.
+// Files which `@include` a shared file from their own directory are loaded
+// with Config::load_file and with cfg::async_load on a thread pool, both must
+// resolve the include. Results are written as JSON to stdout.
+
+static volatile std::uintptr_t bench_sink;
+
+static double bench_now()
+{
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+// Calibrates the number of rounds so one measurement takes ~20ms
+// and returns the best time of one call of `fn` in nanoseconds
+template <typename Fn>
+static double bench_time(std::size_t calls, std::size_t iterations, Fn fn)
+{
+    std::size_t rounds = 1;
+    double best = 0.0;
+    for (std::size_t it = 0; it <= iterations; ++it) {
+        double start = bench_now();
+        for (std::size_t r = 0; r < rounds; ++r) {
+            bench_sink = fn();
+        }
+        double elapsed = bench_now() - start;
+        if (it == 0) {
+            double per_round = elapsed > 0.0 ? elapsed : 1e-9;
+            rounds = static_cast<std::size_t>(0.02 / per_round) + 1;
+            continue;
+        }
+        if (it == 1 || elapsed < best) best = elapsed;
+    }
+    return best * 1e9 / static_cast<double>(rounds * calls);
+}
+
+// `size` variables named k<i>, types cycle through int, double and string
+static std::string bench_generate_flat(std::size_t size)
+{
+    std::string buf;
+    char line[64];
+    for (std::size_t i = 0; i < size; ++i) {
+        switch (i % 3) {
+        case 0:
+            std::snprintf(line, sizeof(line), "k%zu = %zu;\n", i, i);
+            break;
+        case 1:
+            std::snprintf(line, sizeof(line), "k%zu = %zu.5;\n", i, i);
+            break;
+        default:
+            std::snprintf(line, sizeof(line), "k%zu = \"value %zu\";\n", i, i);
+            break;
+        }
+        buf += line;
+    }
+    return buf;
+}
+
+static std::string bench_generate_nested(std::size_t size)
+{
+    std::string buf;
+    char line[128];
+    for (std::size_t i = 0; i < size; ++i) {
+        std::snprintf(line, sizeof(line), "s%zu = { a = %zu; b = [1, 2, 3]; c = { d = \"x\"; e = 1.5; }; };\n", i, i);
+        buf += line;
+    }
+    return buf;
+}
+
+static std::size_t bench_walk_c(Cfg_Variable *ctx)
+{
+    std::size_t count = 0;
+    std::size_t len = cfg_get_context_len(ctx);
+    for (std::size_t i = 0; i < len; ++i) {
+        count++;
+        switch (cfg_get_type_elem(ctx, i)) {
+        case CFG_TYPE_ARRAY:
+            count += bench_walk_c(cfg_get_array_elem(ctx, i));
+            break;
+        case CFG_TYPE_LIST:
+            count += bench_walk_c(cfg_get_list_elem(ctx, i));
+            break;
+        case CFG_TYPE_STRUCT:
+            count += bench_walk_c(cfg_get_struct_elem(ctx, i));
+            break;
+        default:
+            break;
+        }
+    }
+    return count;
+}
+
+static std::size_t bench_walk_cpp(cfg::Node ctx)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < ctx.size(); ++i) {
+        cfg::Node node = ctx.at(i);
+        count++;
+        if (node.is_container()) count += bench_walk_cpp(node);
+    }
+    return count;
+}
+
+struct BenchEndpoint {
+    std::string host;
+    int port = 0;
+    double timeout = 0.0;
+};
+
+struct BenchSettings {
+    std::string name;
+    int workers = 0;
+    bool verbose = false;
+    std::array<double, 3> weights{};
+    std::vector<int> ports;
+    BenchEndpoint primary;
+    std::vector<BenchEndpoint> replicas;
+};
+
+CFG_BIND(BenchEndpoint, CFG_FIELD(host), CFG_FIELD(port), CFG_FIELD(timeout))
+CFG_BIND(BenchSettings, CFG_FIELD(name), CFG_FIELD(workers), CFG_FIELD(verbose), CFG_FIELD(weights),
+         CFG_FIELD(ports), CFG_FIELD(primary), CFG_FIELD(replicas))
+
+// cfg::valid follows the rules of cfg_load_buffer
+static_assert(cfg::valid("a = [1, 2]; b = (1, \"x\", { c = 1; }); d = [{ e = 1; }, { e = 2; }];"));
+static_assert(cfg::valid("a = [[1], [2.5]]; s = { a = 1; }; t = { a = 2; };"));
+static_assert(!cfg::valid("a = [1, \"x\"];"));
+static_assert(!cfg::valid("a = [1, 1.5];"));
+static_assert(!cfg::valid("a = [{ b = 1; }, 2];"));
+static_assert(!cfg::valid("a = 1; a = 2;"));
+static_assert(!cfg::valid("s = { a = 1; a = 2; };"));
+static_assert(!cfg::valid("l = ({ a = 1; a = 2; });"));
+static_assert(!cfg::valid("@include \"common.cfg\"; a = 1;"));
+
+static std::string bench_generate_settings(std::size_t replicas)
+{
+    std::string buf = "name = \"bench\";\nworkers = 8;\nverbose = true;\nweights = (0.5, 1.5, 2.5);\n"
+                      "ports = [8080, 8081, 8082, 8083];\n"
+                      "primary = { host = \"primary.local\"; port = 5432; timeout = 1.5; };\nreplicas = (\n";
+    char line[128];
+    for (std::size_t i = 0; i < replicas; ++i) {
+        std::snprintf(line, sizeof(line), "    { host = \"replica%zu.local\"; port = %zu; timeout = 2.5; },\n", i, 6000 + i);
+        buf += line;
+    }
+    buf += ");\n";
+    return buf;
+}
+
+static void bench_read_endpoint(Cfg_Variable *ctx, BenchEndpoint &out)
+{
+    out.host = cfg_get_string(ctx, "host");
+    out.port = cfg_get_int(ctx, "port");
+    out.timeout = cfg_get_double(ctx, "timeout");
+}
+
+// Hand-written loading through the C API
+static bool bench_load_settings_c(const std::string &src, BenchSettings &out)
+{
+    std::string buf = src;
+    Cfg_Config *cfg = cfg_config_init();
+    if (!cfg || cfg_load_buffer(cfg, buf.data()) != CFG_ERROR_NONE) {
+        cfg_config_deinit(cfg);
+        return false;
+    }
+
+    Cfg_Variable *ctx = cfg_global_context(cfg);
+    out.name = cfg_get_string(ctx, "name");
+    out.workers = cfg_get_int(ctx, "workers");
+    out.verbose = cfg_get_bool(ctx, "verbose");
+    Cfg_Variable *weights = cfg_get_list(ctx, "weights");
+    for (std::size_t i = 0; i < out.weights.size(); ++i) out.weights[i] = cfg_get_double_elem(weights, i);
+    Cfg_Variable *ports = cfg_get_array(ctx, "ports");
+    out.ports.clear();
+    for (std::size_t i = 0; i < cfg_get_context_len(ports); ++i) out.ports.push_back(cfg_get_int_elem(ports, i));
+    bench_read_endpoint(cfg_get_struct(ctx, "primary"), out.primary);
+    Cfg_Variable *replicas = cfg_get_list(ctx, "replicas");
+    out.replicas.resize(cfg_get_context_len(replicas));
+    for (std::size_t i = 0; i < out.replicas.size(); ++i) bench_read_endpoint(cfg_get_struct_elem(replicas, i), out.replicas[i]);
+
+    cfg_config_deinit(cfg);
+    return true;
+}
+
+// Coroutine which starts at once and frees its frame when it finishes
+struct BenchTask {
+    struct promise_type {
+        BenchTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+static BenchTask bench_async_load(cfg::ThreadPool &pool, std::string path, cfg::Config &out, std::atomic<std::size_t> &left)
+{
+    out = co_await cfg::async_load(pool, std::move(path));
+    if (left.fetch_sub(1) == 1) left.notify_one();
+}
+
+// Sum of `shared` (from the included file) and `own` of every config, 0 if any of them failed
+static std::uintptr_t bench_check_included(const std::vector<cfg::Config> &configs)
+{
+    std::uintptr_t acc = 0;
+    for (const cfg::Config &config : configs) {
+        std::optional<int> shared = config.get<int>("shared");
+        std::optional<int> own = config.get<int>("own");
+        if (config.error() != CFG_ERROR_NONE || !shared || !own) return 0;
+        acc += static_cast<std::uintptr_t>(*shared + *own);
+    }
+    return acc;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t iterations = 5;
+    if (argc == 3 && std::strcmp(argv[1], "--iterations") == 0) {
+        iterations = std::strtoull(argv[2], nullptr, 10);
+    } else if (argc != 1) {
+        std::fprintf(stderr, "Usage: %s [--iterations N]\n", argv[0]);
+        return 1;
+    }
+    if (iterations == 0) iterations = 1;
+
+    static const char *types[] = {"int", "double", "string"};
+    static const std::size_t sizes[] = {8, 64, 512};
+
+    std::printf("{\n  \"lookup\": [\n");
+    for (std::size_t s = 0; s < 3; ++s) {
+        std::string buf = bench_generate_flat(sizes[s]);
+        cfg::Config config;
+        if (config.load_buffer(buf.data()) != CFG_ERROR_NONE) {
+            std::fprintf(stderr, "bench_cpp: %s\n", config.error_message().data());
+            return 1;
+        }
+        Cfg_Variable *ctx = cfg_global_context(config.c_ptr());
+        cfg::Node root = config.root();
+
+        for (std::size_t t = 0; t < 3; ++t) {
+            std::vector<std::string> names;
+            for (std::size_t i = t; i < sizes[s]; i += 3) names.push_back("k" + std::to_string(i));
+            std::vector<std::string_view> views(names.begin(), names.end());
+
+            double c_ns = bench_time(names.size(), iterations, [&] {
+                std::uintptr_t acc = 0;
+                for (const std::string &name : names) {
+                    switch (t) {
+                    case 0: acc += static_cast<std::uintptr_t>(cfg_get_int(ctx, name.c_str())); break;
+                    case 1: acc += static_cast<std::uintptr_t>(cfg_get_double(ctx, name.c_str())); break;
+                    default: acc += reinterpret_cast<std::uintptr_t>(cfg_get_string(ctx, name.c_str())); break;
+                    }
+                }
+                return acc;
+            });
+            double cpp_ns = bench_time(views.size(), iterations, [&] {
+                std::uintptr_t acc = 0;
+                for (std::string_view name : views) {
+                    switch (t) {
+                    case 0: acc += static_cast<std::uintptr_t>(root.get<int>(name).value_or(0)); break;
+                    case 1: acc += static_cast<std::uintptr_t>(root.get<double>(name).value_or(0.0)); break;
+                    default: acc += reinterpret_cast<std::uintptr_t>(root.get<std::string_view>(name)->data()); break;
+                    }
+                }
+                return acc;
+            });
+
+            std::printf("    {\"type\": \"%s\", \"context_size\": %zu, \"c_ns\": %.2f, \"cpp_ns\": %.2f}%s\n",
+                        types[t], sizes[s], c_ns, cpp_ns, s + 1 < 3 || t + 1 < 3 ? "," : "");
+        }
+    }
+    std::printf("  ],\n");
+
+    // Literal names: strlen and hashing at runtime against precomputed keys
+    {
+        using namespace cfg::literals;
+        std::string buf = bench_generate_flat(64);
+        cfg::Config config;
+        if (config.load_buffer(buf.data()) != CFG_ERROR_NONE) {
+            std::fprintf(stderr, "bench_cpp: %s\n", config.error_message().data());
+            return 1;
+        }
+        Cfg_Variable *ctx = cfg_global_context(config.c_ptr());
+        cfg::Node root = config.root();
+        double c_ns = bench_time(4, iterations, [&] {
+            return static_cast<std::uintptr_t>(cfg_get_type(ctx, "k1") + cfg_get_type(ctx, "k22")
+                                               + cfg_get_type(ctx, "k43") + cfg_get_type(ctx, "k63"));
+        });
+        double view_ns = bench_time(4, iterations, [&] {
+            return reinterpret_cast<std::uintptr_t>(root["k1"].c_ptr()) + reinterpret_cast<std::uintptr_t>(root["k22"].c_ptr())
+                 + reinterpret_cast<std::uintptr_t>(root["k43"].c_ptr()) + reinterpret_cast<std::uintptr_t>(root["k63"].c_ptr());
+        });
+        double key_ns = bench_time(4, iterations, [&] {
+            return reinterpret_cast<std::uintptr_t>(root["k1"_k].c_ptr()) + reinterpret_cast<std::uintptr_t>(root["k22"_k].c_ptr())
+                 + reinterpret_cast<std::uintptr_t>(root["k43"_k].c_ptr()) + reinterpret_cast<std::uintptr_t>(root["k63"_k].c_ptr());
+        });
+        std::printf("  \"literal\": {\"context_size\": 64, \"c_ns\": %.2f, \"cpp_string_view_ns\": %.2f, \"cpp_key_ns\": %.2f},\n",
+                    c_ns, view_ns, key_ns);
+    }
+
+    std::string nested = bench_generate_nested(2000);
+    cfg::Config config;
+    if (config.load_buffer(nested.data()) != CFG_ERROR_NONE) {
+        std::fprintf(stderr, "bench_cpp: %s\n", config.error_message().data());
+        return 1;
+    }
+    std::size_t nodes = bench_walk_cpp(config.root());
+    double c_walk = bench_time(nodes, iterations, [&] { return bench_walk_c(cfg_global_context(config.c_ptr())); });
+    double cpp_walk = bench_time(nodes, iterations, [&] { return bench_walk_cpp(config.root()); });
+    std::printf("  \"walk\": {\"nodes\": %zu, \"c_ns_per_node\": %.2f, \"cpp_ns_per_node\": %.2f},\n", nodes, c_walk, cpp_walk);
+
+    // Load + free: default allocator against monotonic resource released at once
+    {
+        std::vector<char> buf;
+        std::vector<std::byte> arena(16 << 20);
+        double malloc_ns = bench_time(1, iterations, [&] {
+            buf.assign(nested.begin(), nested.end() + 1);
+            cfg::Config tmp;
+            tmp.load_buffer(buf.data());
+            return static_cast<std::uintptr_t>(tmp.root().size());
+        });
+        double pmr_ns = bench_time(1, iterations, [&] {
+            buf.assign(nested.begin(), nested.end() + 1);
+            std::pmr::monotonic_buffer_resource resource(arena.data(), arena.size());
+            cfg::Config tmp(&resource);
+            tmp.load_buffer(buf.data());
+            std::size_t len = tmp.root().size();
+            tmp.release();
+            return static_cast<std::uintptr_t>(len);
+        });
+        std::printf("  \"pmr\": {\"bytes\": %zu, \"malloc_ns\": %.2f, \"monotonic_ns\": %.2f},\n", nested.size(), malloc_ns, pmr_ns);
+    }
+
+    // Typed array: cfg_get_int_elem per index against cfg::Range<int>
+    {
+        std::string buf = "a = [";
+        for (std::size_t i = 0; i < 4096; ++i) buf += std::to_string(i) + (i + 1 < 4096 ? ", " : "];\n");
+        cfg::Config array;
+        if (array.load_buffer(buf.data()) != CFG_ERROR_NONE) {
+            std::fprintf(stderr, "bench_cpp: %s\n", array.error_message().data());
+            return 1;
+        }
+        Cfg_Variable *ctx = cfg_get_array(cfg_global_context(array.c_ptr()), "a");
+        cfg::Range<int> values = array.root()["a"].values<int>();
+        double c_ns = bench_time(4096, iterations, [&] {
+            std::uintptr_t acc = 0;
+            for (std::size_t i = 0; i < cfg_get_context_len(ctx); ++i) acc += static_cast<std::uintptr_t>(cfg_get_int_elem(ctx, i));
+            return acc;
+        });
+        double range_ns = bench_time(4096, iterations, [&] {
+            std::uintptr_t acc = 0;
+            for (int value : values) acc += static_cast<std::uintptr_t>(value);
+            return acc;
+        });
+        std::printf("  \"iterate\": {\"elements\": 4096, \"c_ns_per_elem\": %.2f, \"range_ns_per_elem\": %.2f},\n", c_ns, range_ns);
+    }
+
+    // Settings struct: load + cfg_get_* + deinit against direct binding
+    std::string settings = bench_generate_settings(64);
+    BenchSettings check;
+    if (!bench_load_settings_c(settings, check) || !cfg::load_buffer<BenchSettings>(settings)) {
+        std::fprintf(stderr, "bench_cpp: failed to load settings\n");
+        return 1;
+    }
+    cfg::Error include_error;
+    if (cfg::load_buffer<BenchSettings>("@include \"common.cfg\";", &include_error) || include_error.type != CFG_ERROR_INCLUDE) {
+        std::fprintf(stderr, "bench_cpp: binding did not reject @include\n");
+        return 1;
+    }
+    double c_load = bench_time(1, iterations, [&] {
+        BenchSettings out;
+        bench_load_settings_c(settings, out);
+        return static_cast<std::uintptr_t>(out.replicas.size());
+    });
+    double bind_load = bench_time(1, iterations, [&] {
+        return static_cast<std::uintptr_t>(cfg::load_buffer<BenchSettings>(settings)->replicas.size());
+    });
+    std::printf("  \"binding\": {\"bytes\": %zu, \"c_get_ns\": %.2f, \"bind_ns\": %.2f},\n", settings.size(), c_load, bind_load);
+
+    // Files including `common.cfg` of their directory: load_file one by one against async_load on a pool
+    {
+        const std::size_t count = 64;
+        char dir_template[] = "/tmp/bench_cpp.XXXXXX";
+        if (!mkdtemp(dir_template)) {
+            std::perror("bench_cpp: mkdtemp");
+            return 1;
+        }
+        std::filesystem::path dir = dir_template;
+        std::ofstream(dir / "common.cfg") << "shared = 1;\n" << bench_generate_flat(64);
+        std::vector<std::string> paths;
+        for (std::size_t i = 0; i < count; ++i) {
+            paths.push_back((dir / ("app" + std::to_string(i) + ".cfg")).string());
+            std::ofstream(paths.back()) << "@include \"common.cfg\";\nown = " << i << ";\n";
+        }
+        std::uintptr_t expected = count + count * (count - 1) / 2;
+
+        std::vector<cfg::Config> configs;
+        auto load_sync = [&] {
+            configs.clear();
+            for (const std::string &path : paths) {
+                cfg::Config config;
+                config.load_file(path.c_str());
+                configs.push_back(std::move(config));
+            }
+            return bench_check_included(configs);
+        };
+        cfg::ThreadPool pool(4);
+        auto load_async = [&] {
+            configs.clear();
+            for (std::size_t i = 0; i < count; ++i) configs.emplace_back(nullptr);
+            std::atomic<std::size_t> left = count;
+            for (std::size_t i = 0; i < count; ++i) bench_async_load(pool, paths[i], configs[i], left);
+            for (std::size_t n = left.load(); n != 0; n = left.load()) left.wait(n);
+            return bench_check_included(configs);
+        };
+        bool sync_ok = load_sync() == expected;
+        bool async_ok = load_async() == expected;
+        double sync_ns = bench_time(count, iterations, load_sync);
+        double async_ns = bench_time(count, iterations, load_async);
+        configs.clear();
+        std::filesystem::remove_all(dir);
+        if (!sync_ok || !async_ok) {
+            std::fprintf(stderr, "bench_cpp: included file was not resolved (load_file %s, async_load %s)\n",
+                         sync_ok ? "ok" : "failed", async_ok ? "ok" : "failed");
+            return 1;
+        }
+        std::printf("  \"async\": {\"files\": %zu, \"threads\": %zu, \"load_file_ns_per_file\": %.2f, \"async_load_ns_per_file\": %.2f}\n",
+                    count, pool.size(), sync_ns, async_ns);
+    }
+    std::printf("}\n");
+
+    return 0;
+}
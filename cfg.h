@@ -28,13 +28,35 @@
 #define CFG_H_
 
 #include <ctype.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define ERROR_MESSAGE_LEN 512
 
+// Names and values shorter than this (with terminating zero, both together)
+// are stored inside of Cfg_Variable instead of separate allocations
+#define CFG_INLINE_SIZE 16
+
+// Default memory functions, can be overridden before including cfg.h
+// Used when config is initialized without custom allocator
+#ifndef CFG_MALLOC
+#define CFG_MALLOC(size) malloc(size)
+#endif
+#ifndef CFG_REALLOC
+#define CFG_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+#ifndef CFG_FREE
+#define CFG_FREE(ptr) free(ptr)
+#endif
+
 // Supported variable types
 typedef enum {
     CFG_TYPE_NONE = 0, // If variable does not exist
@@ -59,6 +81,8 @@ typedef enum {
     CFG_ERROR_VARIABLE_NOT_FOUND,
     CFG_ERROR_VARIABLE_WRONG_TYPE,
     CFG_ERROR_VARIABLE_PARSE,
+    CFG_ERROR_CONFIG_SHARED,
+    CFG_ERROR_INCLUDE,
     CFG_ERROR_COUNT,
 } Cfg_Error_Type;
 
@@ -77,27 +101,215 @@ struct Cfg_Variable {
     Cfg_Variable *vars;
     size_t vars_len;
     size_t vars_cap;
-    Cfg_Error err;
+    unsigned char string_flags; // Where name/value/vars are stored (inline_buf, interned, own allocation or base of clone)
+    char inline_buf[CFG_INLINE_SIZE];
 };
 
+// Load statistics
+// Collected only when the implementation is compiled with CFG_STATS defined,
+// all counters are cumulative since `cfg_config_init`
+typedef struct {
+    uint64_t tokenize_ns; // Time spent in tokenizer
+    uint64_t parse_ns;    // Time spent in parser
+    size_t bytes;         // Bytes of input processed
+    size_t tokens;        // Tokens produced by tokenizer
+    size_t ints;          // Number of variables per type
+    size_t doubles;
+    size_t bools;
+    size_t strings;
+    size_t arrays;
+    size_t lists;
+    size_t structs;
+    size_t max_depth;     // Deepest nesting of arrays/lists/structs
+    size_t alloc_count;   // Number of allocations (realloc counts as one)
+    size_t alloc_bytes;   // Total bytes requested by allocations
+    size_t memory;        // Bytes currently allocated
+    size_t peak_memory;   // Maximum of `memory`
+} Cfg_Stats;
+
+// Custom allocator
+// Every allocation of a config (including config itself) goes through it,
+// `ctx` is passed to every call. Sizes of blocks are passed to `realloc` and `free`
+// so pool and arena allocators do not need to store them.
+// `realloc` can be NULL, then `alloc` + `free` are used instead.
 typedef struct {
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} Cfg_Allocator;
+
+// Memory used by config
+// Counters are updated on every allocation, reading them is O(1)
+typedef struct {
+    size_t total;       // Bytes allocated by config, including config itself
+    size_t nodes;       // Bytes of variables (Cfg_Variable and name hash) in use
+    size_t names;       // Bytes of variable names
+    size_t values;      // Bytes of variable values
+    size_t slack;       // Bytes of unused variable slots (vars_cap - vars_len)
+    size_t lexer;       // Bytes held by tokenizer/parser, 0 when no load is running
+    size_t unused;      // Bytes of compacted block which are not referenced anymore
+    size_t interned;    // Bytes of interned values and their hash set
+    size_t intern_saved; // Bytes of values shared with other variables instead of being copied
+    size_t includes;    // Bytes of included files list kept to validate cached includes
+    size_t allocations; // Number of live allocations
+} Cfg_MemInfo;
+
+// Hash set of interned values, see `cfg_config_intern_values`
+typedef struct {
+    char **slots;        // Open addressing table, NULL is empty slot
+    size_t len;
+    size_t cap;
+    size_t strings_size; // Bytes of interned values
+    size_t refs_size;    // Bytes of values of all variables referencing interned values
+    bool enabled;
+} Cfg_Intern;
+
+typedef struct Cfg_Config {
     Cfg_Variable global;
     Cfg_Error err;
+    Cfg_Stats stats;
+    Cfg_Allocator allocator;
+    Cfg_MemInfo mem;
+    char *block;        // Single allocation made by `cfg_config_compact`
+    size_t block_size;
+    Cfg_Intern intern;
+    struct Cfg_Config *base; // Config whose tree is shared by this clone, see `cfg_config_clone`
+    size_t clones;      // Number of clones sharing tree of this config
+    bool released;      // Deinitialized while clones were alive, freed with the last one
+    size_t generation;  // Incremented by every change of tree (load, modification, compaction)
+    const char *file;   // File being loaded, relative includes are resolved against its directory
+    struct Cfg_Include_Dep *includes; // Files included by loads (directly or not), validate cached includes
+    size_t includes_len;
 } Cfg_Config;
 
+// Node of compact image, 12 bytes
+// Inner nodes of array/list/struct are stored next to each other
+typedef struct {
+    uint32_t name;  // Offset of name in strings, CFG_IMAGE_NO_NAME for array/list elements
+    uint32_t value; // Offset of value in strings or index of first inner node
+    uint32_t info;  // Type in low 3 bits (see CFG_IMAGE_TYPE_BITS), number of inner nodes in others
+} Cfg_Image_Node;
+
+#define CFG_IMAGE_NO_NAME UINT32_MAX
+#define CFG_IMAGE_TYPE_BITS 3
+
+// Read-only compact image of config, see `cfg_image_build`
+// Everything lives in one block: header, nodes, hashes of names and strings,
+// all references inside of it are 32-bit offsets and indices
+typedef struct {
+    const Cfg_Image_Node *nodes; // nodes[0] is global context
+    const uint32_t *hashes;      // Hashes of names of nodes
+    const char *strings;         // Names and values
+    uint32_t nodes_len;
+    uint32_t strings_size;
+    void *data;
+    size_t size;
+    Cfg_Allocator allocator;
+    bool shared; // Data is mapped by `cfg_attach_shared`
+} Cfg_Image;
+
+// Handle of image node, passed by value
+// Handle of not existing node has idx CFG_IMAGE_NO_NODE
+typedef struct {
+    const Cfg_Image *image;
+    uint32_t idx;
+} Cfg_Node;
+
+#define CFG_IMAGE_NO_NODE UINT32_MAX
+
+// Entry of path cache of overlay
+typedef struct {
+    char *path;        // NULL is empty slot
+    uint32_t hash;
+    size_t stamp;      // Stamp of overlay when `var` was resolved
+    Cfg_Variable *var; // NULL if no layer has the path
+} Cfg_Overlay_Entry;
+
+// Stack of configs resolved from top to bottom, see `cfg_overlay_init`
+typedef struct {
+    Cfg_Config **layers;      // Bottom to top
+    size_t *generations;      // Generations of layers when they were last checked
+    size_t layers_len;
+    size_t layers_cap;
+    size_t stamp;             // Changed when any layer changes, entries with older stamp are stale
+    Cfg_Overlay_Entry *cache; // Open addressing table of resolved paths
+    size_t cache_len;
+    size_t cache_cap;
+} Cfg_Overlay;
+
 // Public API functions declaration
 
 // Initialize config variable
 Cfg_Config *cfg_config_init(void);
 
+// Initialize config variable which allocates memory with provided allocator
+// If allocator is NULL CFG_MALLOC/CFG_REALLOC/CFG_FREE are used
+Cfg_Config *cfg_config_init_allocator(const Cfg_Allocator *allocator);
+
 // Deinitialize config variable
 // Should be called to free memory
 void cfg_config_deinit(Cfg_Config *cfg);
 
+// Intern values of variables loaded after this call
+// Identical values which do not fit inline share one copy owned by config,
+// see `intern_saved` of Cfg_MemInfo. Interned values live until config is deinitialized.
+void cfg_config_intern_values(Cfg_Config *cfg, bool enable);
+
+// Relocate all variables of config into a single allocation
+// Variables are placed in depth-first order with exact-size arrays (each one is
+// followed by hashes of its names), followed by all names and values.
+// Unused memory is returned to allocator.
+// Pointers to variables and strings obtained before are invalidated.
+// Config can still be loaded into after compaction.
+// Returns CFG_ERROR_CONFIG_SHARED for clones and configs with clones
+Cfg_Error_Type cfg_config_compact(Cfg_Config *cfg);
+
+// Make copy-on-write clone of config in O(1)
+// Clone shares the whole tree with `cfg`, modifying or loading into clone copies only arrays of
+// variables on the path from global context to the modified context (and the new values).
+// Arrays are copied whole, about 84 bytes per variable on 64-bit: one changed value in a global
+// context of 2000 variables copies all 2000 of them (~170 KB), the same change in a struct of
+// 8 variables nested in it copies 2008. Strings and untouched contexts are never copied.
+// Contexts of `cfg` obtained from clone may be passed to modifying functions of clone, they are
+// resolved by names and element indexes from global context.
+// While clones are alive `cfg` is read-only: loading, modifying and compaction fail with
+// CFG_ERROR_CONFIG_SHARED, and `cfg_config_deinit` of it is deferred until the last clone is
+// deinitialized. Clones of one config must not be created or deinitialized concurrently.
+// Returns NULL if there is no memory
+Cfg_Config *cfg_config_clone(Cfg_Config *cfg);
+
 // Loading buffer/stream/file
 Cfg_Error_Type cfg_load_buffer(Cfg_Config *cfg, char *buffer);
 Cfg_Error_Type cfg_load_stream(Cfg_Config *cfg, FILE *stream);
 Cfg_Error_Type cfg_load_file(Cfg_Config *cfg, const char *path);
+// Load buffer holding contents of file `path`, which is used to resolve relative includes
+// and detect include cycles the same way as in cfg_load_file, the file itself is not opened
+Cfg_Error_Type cfg_load_buffer_path(Cfg_Config *cfg, char *buffer, const char *path);
+
+// Load `count` files, `paths[i]` into `cfgs[i]` (NULL configs are skipped)
+// When the implementation is compiled with CFG_IO_URING on Linux, opens, reads and
+// closes of up to 128 files are submitted in one io_uring batch and every file is parsed
+// as soon as its read returns end of file. Otherwise (or if io_uring is not available
+// or fails) each remaining file is read with pread. Returns number of files loaded without error,
+// errors are reported by each config
+size_t cfg_load_files(Cfg_Config **cfgs, const char *const *paths, size_t count);
+
+// Includes
+// `@include "path";` in global context or struct copies variables of the included file into it,
+// redefinition of a variable is an error. Relative paths are resolved against directory of the
+// including file (current directory for buffers and streams). Include cycles and errors of
+// included files fail with CFG_ERROR_INCLUDE. Included files are parsed once per process:
+// parsed configs are cached by canonical path and revalidated with stat (modification time,
+// size, inode) of the file and of files it includes on every include, so a file shared by
+// many configs is read again only after it changes. Included files which are not cached yet
+// are loaded together with `cfg_load_files` before the including file is parsed.
+// Cache is shared by threads. It is process wide, so its entries, their paths and cached configs
+// (which use default allocator) are allocated with CFG_MALLOC/CFG_FREE and not with allocator
+// of the including config; only variables copied into the including config use its allocator.
+// `cfg_include_cache_clear` frees cached configs (configs being copied right now are freed
+// by their last include)
+void cfg_include_cache_clear(void);
 
 // Get global context in config
 Cfg_Variable *cfg_global_context(Cfg_Config *config);
@@ -116,11 +328,70 @@ char *cfg_get_name(Cfg_Variable *ctx, size_t idx);
 Cfg_Type cfg_get_type(Cfg_Variable *ctx, const char *name);
 Cfg_Type cfg_get_type_elem(Cfg_Variable *ctx, size_t idx);
 
+// Find variable by name of `len` bytes, name does not need terminating zero
+// Returns NULL if there is no such variable, lookup is not counted by telemetry
+Cfg_Variable *cfg_find_variable(Cfg_Variable *ctx, const char *name, size_t len);
+
+// Hash of variable name used by lookups (32-bit FNV-1a of `len` bytes)
+// `cfg_find_variable_hashed` skips hashing, `hash` must be `cfg_hash(name, len)`
+uint32_t cfg_hash(const char *name, size_t len);
+Cfg_Variable *cfg_find_variable_hashed(Cfg_Variable *ctx, const char *name, size_t len, uint32_t hash);
+
+// Modify loaded config
+// Set value of variable `name` of struct or global context, variable is added if there is none
+// Value is rewritten in place when the variable has the same type and new value fits where the
+// old one is stored (inline buffer, its own copy or compacted block), otherwise it is stored
+// like a loaded value. Returns CFG_ERROR_VARIABLE_WRONG_TYPE if variable has another type,
+// errors are reported by config (see `cfg_err_type`)
+Cfg_Error_Type cfg_set_int(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, int value);
+Cfg_Error_Type cfg_set_double(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, double value);
+Cfg_Error_Type cfg_set_bool(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, bool value);
+Cfg_Error_Type cfg_set_string(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, const char *value);
+
+// Add variable to context: named variable to struct or global context, element (`name` is NULL)
+// to array or list. `value` is the scalar written as in config (strings without quotes), NULL
+// for array/list/struct. Elements of array must have type of its first element.
+// Name must be identifier of config, all checks are done before config is changed
+// Variables are appended into storage which grows by doubling, so insert is amortized O(1)
+// and keeps hash index of context up to date.
+// Returns added variable or NULL on error
+// Pointers to inner variables of `ctx` obtained before may be invalidated
+Cfg_Variable *cfg_insert(Cfg_Config *cfg, Cfg_Variable *ctx, Cfg_Type type, const char *name, const char *value);
+
+// Remove variable by name/index with all its inner variables
+// Order of the rest is kept, pointers to variables after removed one are invalidated
+Cfg_Error_Type cfg_remove(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name);
+Cfg_Error_Type cfg_remove_elem(Cfg_Config *cfg, Cfg_Variable *ctx, size_t idx);
+
 // Config error information
 Cfg_Error_Type cfg_err_type(Cfg_Config *cfg);
 char *cfg_err_message(Cfg_Config *cfg);
 
+// Memory usage of config, see Cfg_MemInfo
+void cfg_memory_usage(Cfg_Config *cfg, Cfg_MemInfo *info);
+
+// Load statistics
+// Returns NULL if library was compiled without CFG_STATS
+const Cfg_Stats *cfg_stats(Cfg_Config *cfg);
+
+// Lookup telemetry
+// When the library is compiled with CFG_TELEMETRY defined every lookup by name
+// (cfg_get_<type_name>, cfg_get_<type_name>_safe, cfg_get_type) counts hits,
+// misses and wrong type accesses per key. Counters are process wide relaxed atomics
+// keyed by config and path of names (indexes of array/list elements) from global context,
+// so they follow variables when contexts are moved by compaction, inserts or copy-on-write
+// of clones. A config allocated where a deinitialized one was continues its counters.
+// `cfg_telemetry_dump` prints counters of every variable in config (including
+// never read ones) and of looked up keys which are not defined.
+// Both functions do nothing without CFG_TELEMETRY.
+void cfg_telemetry_dump(Cfg_Config *cfg, FILE *out);
+void cfg_telemetry_reset(void);
+
 // Variable error information
+// Error of the last failed cfg_get_<type_name>_safe call of the calling thread if it was
+// made on `ctx`, CFG_ERROR_NONE/NULL otherwise. Errors are kept in thread-local storage:
+// reading a loaded config never writes to its memory, so pages stay shared after fork
+// and concurrent readers do not race
 Cfg_Error_Type cfg_context_err_type(Cfg_Variable *ctx);
 char *cfg_context_err_message(Cfg_Variable *ctx);
 
@@ -156,10 +427,137 @@ Cfg_Variable *cfg_get_array_elem(Cfg_Variable *ctx, size_t idx);
 Cfg_Variable *cfg_get_list_elem(Cfg_Variable *ctx, size_t idx);
 Cfg_Variable *cfg_get_struct_elem(Cfg_Variable *ctx, size_t idx);
 
+// Compact image of config
+// `cfg_image_build` copies loaded config into a read-only image allocated
+// with allocator of config, config can be modified or deinitialized afterwards.
+// Returns NULL on error, see `cfg_err_type` and `cfg_err_message`
+Cfg_Image *cfg_image_build(Cfg_Config *cfg);
+void cfg_image_free(Cfg_Image *image);
+
+// Image shared between processes
+// `cfg_image_share` copies image into a new memory file (memfd on Linux, unlinked
+// POSIX shared memory object elsewhere), seals it against changes where supported
+// and returns its descriptor, -1 on error. Image can be freed afterwards.
+// `cfg_attach_shared` maps image read-only from descriptor inherited by fork or
+// passed over a unix socket, all processes read the same physical pages.
+// Returns NULL if descriptor can not be mapped or does not contain a valid image
+// (offsets, indices and strings of all nodes are checked once, in O(number of nodes)),
+// image must be freed with `cfg_image_free` (it unmaps the data)
+int cfg_image_share(const Cfg_Image *image);
+Cfg_Image *cfg_attach_shared(int fd);
+
+// Get handle of global context of image
+Cfg_Node cfg_image_root(const Cfg_Image *image);
+
+// Image nodes by handle, mirror cfg_get_* functions
+// Lookups return handle with idx CFG_IMAGE_NO_NODE if there is no such node,
+// getters of values return 0/0.0/false/NULL on error (no node or wrong type)
+bool cfg_node_valid(Cfg_Node node);
+Cfg_Type cfg_node_type(Cfg_Node node);
+size_t cfg_node_len(Cfg_Node node);
+const char *cfg_node_name(Cfg_Node node);
+Cfg_Node cfg_node_get(Cfg_Node ctx, const char *name);
+Cfg_Node cfg_node_elem(Cfg_Node ctx, size_t idx);
+int cfg_node_int(Cfg_Node node);
+double cfg_node_double(Cfg_Node node);
+bool cfg_node_bool(Cfg_Node node);
+const char *cfg_node_string(Cfg_Node node);
+
+// Layered lookup
+// Overlay stacks configs (e.g. defaults, file, environment, command line) without merging them.
+// Variables are looked up by path of names separated by `.` (elements of arrays/lists by index,
+// `servers.0.host`) in every layer from top to bottom, the first layer which has the path wins.
+// Structs are merged lazily: `a.b` is found in struct `a` of any layer, so a layer may
+// override single variables of a struct. Resolved paths (and misses) are cached, cache
+// entries are revalidated when generation of any layer changes (load, modification or
+// compaction of it) or layers are replaced. Layers are not owned and must outlive overlay.
+// Lookups update cache, so one overlay must not be read from several threads at once.
+// `cfg_overlay_init` returns NULL and `cfg_overlay_push` false if there is no memory
+Cfg_Overlay *cfg_overlay_init(void);
+void cfg_overlay_deinit(Cfg_Overlay *overlay);
+bool cfg_overlay_push(Cfg_Overlay *overlay, Cfg_Config *cfg);
+void cfg_overlay_set_layer(Cfg_Overlay *overlay, size_t idx, Cfg_Config *cfg);
+
+// Get variable by path from overlay, NULL if no layer has it
+Cfg_Variable *cfg_overlay_find(Cfg_Overlay *overlay, const char *path);
+
+// Get variables from overlay by path, mirror cfg_get_* functions
+// Return CFG_TYPE_NONE or 0/0.0/false/NULL on error (no such variable or wrong type)
+Cfg_Type cfg_overlay_get_type(Cfg_Overlay *overlay, const char *path);
+int cfg_overlay_get_int(Cfg_Overlay *overlay, const char *path);
+double cfg_overlay_get_double(Cfg_Overlay *overlay, const char *path);
+bool cfg_overlay_get_bool(Cfg_Overlay *overlay, const char *path);
+char *cfg_overlay_get_string(Cfg_Overlay *overlay, const char *path);
+
+// Environment variable layer
+// Loads environment variables named `<prefix><PATH>` into `cfg` and pushes it on top of overlay.
+// PATH is path of a scalar variable defined in any layer in upper case with `__` between names
+// (`APP_STRUCTURE__NESTED__DOUBLE` overrides `structure.nested.double`, other characters of
+// names become `_`). Paths of layers are hashed once and `envp` (process environment if NULL)
+// is scanned once, reads never call getenv. Values are converted to the type of variable they
+// override: ints are decimal with optional `-` and must fit in int, doubles may also have a
+// fraction and exponent (`-1.5e3`) and must be finite; spaces, `+`, hex, inf and nan are
+// rejected. Bools accept true/false/yes/no/on/off/1/0 in any case.
+// Environment variables which do not name a variable are ignored. Returns the first error
+// (see `cfg_err_type` of `cfg`), the rest of variables is still loaded
+Cfg_Error_Type cfg_overlay_push_env(Cfg_Overlay *overlay, Cfg_Config *cfg, const char *prefix, char **envp);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // CFG_H_
 
 #ifdef CFG_IMPLEMENTATION
 
+#include <errno.h>
+#include <math.h>
+
+#ifdef CFG_STATS
+#include <time.h>
+#endif
+
+// pread needs POSIX.1-2008 declarations, not available with strict -std=c99 without feature macros
+#if defined(__APPLE__) || (defined(__unix__) && (defined(_DEFAULT_SOURCE) || defined(_GNU_SOURCE) \
+    || (defined(_XOPEN_SOURCE) && _XOPEN_SOURCE >= 500) || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L)))
+#define CFG_POSIX_IO
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// Nanoseconds of modification time, validate cached includes changed within the same second
+#if defined(__APPLE__)
+#define CFG_MTIME_NSEC(st) ((st).st_mtimespec.tv_nsec)
+#elif defined(_DEFAULT_SOURCE) || defined(_GNU_SOURCE) || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L) \
+    || (defined(_XOPEN_SOURCE) && _XOPEN_SOURCE >= 700)
+#define CFG_MTIME_NSEC(st) ((st).st_mtim.tv_nsec)
+#else
+#define CFG_MTIME_NSEC(st) 0
+#endif
+// realpath is XSI, without it included files are cached by joined path
+#if defined(__APPLE__) || defined(_DEFAULT_SOURCE) || defined(_GNU_SOURCE) || (defined(_XOPEN_SOURCE) && _XOPEN_SOURCE >= 500)
+#define CFG_REALPATH
+#endif
+#endif
+
+// Process environment scanned by `cfg_overlay_push_env` when no `envp` is passed
+#if defined(__unix__) || defined(__APPLE__)
+extern char **environ;
+#define CFG_ENVIRON environ
+#elif defined(_WIN32)
+#define CFG_ENVIRON _environ
+#else
+#define CFG_ENVIRON NULL
+#endif
+
+#if defined(CFG_IO_URING) && defined(__linux__) && defined(CFG_POSIX_IO) && (defined(_DEFAULT_SOURCE) || defined(_GNU_SOURCE))
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <time.h>
+#else
+#undef CFG_IO_URING
+#endif
+
 // Private functions and types
 
 #define INIT_VARIABLES_NUM 64
@@ -168,6 +566,122 @@ Cfg_Variable *cfg_get_struct_elem(Cfg_Variable *ctx, size_t idx);
 #define INIT_STACK_SIZE 64
 
 #define FILE_MAX_SIZE 10 * 1024 * 1024
+#define FILE_READ_CHUNK (16 * 1024) // First read of a file, grown by doubling
+#define FILES_BATCH 128             // Files per io_uring batch of `cfg_load_files`
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define CFG_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define CFG_THREAD_LOCAL __declspec(thread)
+#else
+#define CFG_THREAD_LOCAL __thread
+#endif
+
+// Atomics of include cache lock and telemetry counters: GNU/clang builtins or C11 atomics
+#if defined(__GNUC__) || defined(__clang__)
+#define CFG_ATOMIC(type) type
+#define CFG_RELAXED __ATOMIC_RELAXED
+#define CFG_ACQUIRE __ATOMIC_ACQUIRE
+#define CFG_RELEASE __ATOMIC_RELEASE
+#define cfg__atomic_load(ptr, order) __atomic_load_n(ptr, order)
+#define cfg__atomic_store(ptr, val, order) __atomic_store_n(ptr, val, order)
+#define cfg__atomic_exchange(ptr, val, order) __atomic_exchange_n(ptr, val, order)
+#define cfg__atomic_add(ptr, val) __atomic_fetch_add(ptr, val, __ATOMIC_RELAXED)
+#define cfg__atomic_cas(ptr, expected, val) \
+    __atomic_compare_exchange_n(ptr, expected, val, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define CFG_ATOMIC(type) _Atomic(type)
+#define CFG_RELAXED memory_order_relaxed
+#define CFG_ACQUIRE memory_order_acquire
+#define CFG_RELEASE memory_order_release
+#define cfg__atomic_load(ptr, order) atomic_load_explicit(ptr, order)
+#define cfg__atomic_store(ptr, val, order) atomic_store_explicit(ptr, val, order)
+#define cfg__atomic_exchange(ptr, val, order) atomic_exchange_explicit(ptr, val, order)
+#define cfg__atomic_add(ptr, val) atomic_fetch_add_explicit(ptr, val, memory_order_relaxed)
+#define cfg__atomic_cas(ptr, expected, val) \
+    atomic_compare_exchange_strong_explicit(ptr, expected, val, memory_order_acq_rel, memory_order_acquire)
+#else
+#error "cfg.h needs GNU atomic builtins or C11 atomics"
+#endif
+
+// Memory used by one variable of a context: variable itself and hash of its name
+#define CFG_SLOT_SIZE (sizeof(Cfg_Variable) + sizeof(uint32_t))
+
+// Flags of Cfg_Variable.string_flags
+// Inline name starts at inline_buf, inline value follows it (or starts there if name is not inline)
+// Shared value is owned by Cfg_Config.intern
+// Borrowed name/value/vars belong to base of clone and are never written or freed by it
+#define CFG_INLINE_NAME 1
+#define CFG_INLINE_VALUE 2
+#define CFG_SHARED_VALUE 4
+#define CFG_BORROWED_NAME 8
+#define CFG_BORROWED_VALUE 16
+#define CFG_BORROWED_VARS 32
+
+#define INIT_INTERN_SLOTS 256
+#define INIT_OVERLAY_SLOTS 64
+#define INIT_ENV_SLOTS 256
+#define ENV_NAME_MAX 256
+
+// Map of environment names of variables, see `cfg_overlay_push_env`
+typedef struct {
+    char *name;        // PATH part of environment name, NULL is empty slot
+    uint32_t hash;
+    Cfg_Variable *var; // Variable of layer which defines type
+} Cfg_Env_Slot;
+
+typedef struct {
+    Cfg_Env_Slot *slots;
+    size_t len;
+    size_t cap;
+} Cfg_Env_Map;
+
+#ifdef PATH_MAX
+#define INCLUDE_PATH_MAX PATH_MAX
+#else
+#define INCLUDE_PATH_MAX 4096
+#endif
+#define INIT_INCLUDE_ENTRIES 16
+
+// State of included file when it was parsed, cached parse is used while it is the same
+typedef struct {
+    long long mtime_sec;
+    long long mtime_nsec;
+    long long size;
+    unsigned long long ino;
+    unsigned long long dev;
+} Cfg_Include_Stamp;
+
+// File included by config and its state when it was included
+typedef struct Cfg_Include_Dep {
+    char *path;
+    Cfg_Include_Stamp stamp;
+} Cfg_Include_Dep;
+
+// Parsed included file, see `cfg_include_cache_clear`
+typedef struct {
+    char *path;       // Canonical path
+    uint32_t hash;
+    Cfg_Include_Stamp stamp;
+    Cfg_Config *cfg;
+    size_t refs;      // Includes copying variables of `cfg` right now
+    bool stale;       // Removed from cache while referenced, freed by the last include
+} Cfg_Include;
+
+// Files with includes being parsed by thread, innermost first
+typedef struct Cfg_Include_Frame {
+    char *path; // Canonical path
+    struct Cfg_Include_Frame *prev;
+} Cfg_Include_Frame;
+
+#ifdef CFG_TELEMETRY
+// Number of keys telemetry can track, must be a power of two
+#ifndef CFG_TELEMETRY_SLOTS
+#define CFG_TELEMETRY_SLOTS 16384
+#endif
+#define CFG_TELEMETRY_NAME_LEN 64
+#endif
 
 typedef enum {
     // Types with string literal values
@@ -187,11 +701,13 @@ typedef enum {
     CFG_TOKEN_DOUBLE = 4096,
     CFG_TOKEN_BOOL = 8192,
     CFG_TOKEN_STRING = 16384,
+    CFG_TOKEN_INCLUDE = 32768,
 } Cfg_Token_Type;
 
 typedef struct {
     Cfg_Token_Type type;
     char *value;
+    size_t size; // Allocated size of value, 0 for string literals
     size_t line;
     size_t column;
 } Cfg_Token;
@@ -202,7 +718,23 @@ typedef struct {
     size_t cap;
 } Cfg_Stack;
 
+#ifdef CFG_TELEMETRY
 typedef struct {
+    CFG_ATOMIC(uint64_t) key; // 0 if slot is free
+    CFG_ATOMIC(uint64_t) hits;
+    CFG_ATOMIC(uint64_t) misses;
+    CFG_ATOMIC(uint64_t) wrong_type;
+    uint64_t ctx_key; // Key of context, see `cfg__telemetry_context_key`
+    CFG_ATOMIC(bool) ready; // Set after ctx_key and name are written
+    char name[CFG_TELEMETRY_NAME_LEN];
+} Cfg_Telemetry_Slot;
+
+static Cfg_Telemetry_Slot cfg__telemetry_slots[CFG_TELEMETRY_SLOTS];
+static CFG_ATOMIC(uint64_t) cfg__telemetry_dropped;
+#endif
+
+typedef struct {
+    Cfg_Config *cfg;
     char *str_start;
     char *ch_current;
     Cfg_Token *tokens;
@@ -214,55 +746,437 @@ typedef struct {
     bool comment_eol;
     bool comment;
     Cfg_Stack stack;
+#ifdef CFG_STATS
+    size_t bytes;
+#endif
 } Cfg_Lexer;
 
+// Error of the last failed lookup of thread and context it was made on
+typedef struct {
+    const Cfg_Variable *ctx;
+    Cfg_Error err;
+} Cfg_Context_Error;
+
+static CFG_THREAD_LOCAL Cfg_Context_Error cfg__context_err;
+
+// Spin lock of include cache, 1 while it is held
+typedef CFG_ATOMIC(int) Cfg_Lock;
+#define CFG_LOCK_INIT 0
+
+// Process wide cache of included files, entries are changed under spin lock,
+// entries which are dropped are freed after it is unlocked
+static struct {
+    Cfg_Include **entries;
+    size_t len;
+    size_t cap;
+    Cfg_Lock lock;
+} cfg__includes = {NULL, 0, 0, CFG_LOCK_INIT};
+
+static CFG_THREAD_LOCAL Cfg_Include_Frame *cfg__include_stack;
+
 // Private functions forward declaration
 
+// Memory functions, every allocation of the library goes through them
+// Sizes are passed to realloc/free to keep statistics
+static void *cfg__alloc(Cfg_Config *cfg, size_t size);
+static void *cfg__realloc(Cfg_Config *cfg, void *ptr, size_t old_size, size_t new_size);
+static void cfg__free(Cfg_Config *cfg, void *ptr, size_t size);
+static char *cfg__strdup(Cfg_Config *cfg, const char *str);
+
+// Default allocator functions
+static void *cfg__default_alloc(void *ctx, size_t size);
+static void *cfg__default_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size);
+static void cfg__default_free(void *ctx, void *ptr, size_t size);
+
+#ifdef CFG_STATS
+static uint64_t cfg__time_ns(void);
+static void cfg__stats_memory(Cfg_Config *cfg, size_t old_size, size_t new_size);
+static void cfg__stats_load(Cfg_Config *cfg, Cfg_Lexer *lexer, uint64_t start, uint64_t tokenized);
+#endif
+
 // Cfg_Lexer create and free
 static Cfg_Lexer *cfg__lexer_create(Cfg_Config *cfg);
 static void cfg__lexer_free(Cfg_Lexer *lexer);
 
 // Functions for parsing string
-static void cfg__string_add_char(char **str, size_t *cap, char ch);
-static char *cfg__lexer_parse_string_buffer(Cfg_Lexer *lexer);
-static char *cfg__lexer_parse_string_stream(Cfg_Lexer *lexer, FILE *stream);
+static void cfg__string_add_char(Cfg_Lexer *lexer, char **str, size_t *cap, char ch);
+static char *cfg__lexer_parse_string_buffer(Cfg_Lexer *lexer, size_t *size);
+static char *cfg__lexer_parse_string_stream(Cfg_Lexer *lexer, FILE *stream, size_t *size);
+
+// Read/unread character from stream
+static int cfg__lexer_getc(Cfg_Lexer *lexer, FILE *stream);
+static void cfg__lexer_ungetc(Cfg_Lexer *lexer, int c, FILE *stream);
 
 // Add token to lexer
-static void cfg__lexer_add_token(Cfg_Lexer *lexer, Cfg_Token_Type type, char *value);
+// `size` is allocated size of value, 0 if value is not allocated
+static void cfg__lexer_add_token(Cfg_Lexer *lexer, Cfg_Token_Type type, char *value, size_t size);
 
 // Stack functions for brakets and parenthesis evaluation
 static void cfg__stack_add_char(Cfg_Lexer *lexer, char ch);
 static void cfg__stack_pop_char(Cfg_Lexer *lexer);
 static char cfg__stack_last_char(Cfg_Lexer *lexer);
 
+// Hash of variable name (32-bit FNV-1a)
+static uint32_t cfg__hash(const char *name, size_t len);
+
+// Inner variables of context and hashes of their names live in one block:
+// `vars_cap` variables followed by `vars_cap` hashes, so a name lookup scans
+// a dense array of hashes and compares strings only on hash match
+static size_t cfg__vars_size(size_t cap);
+static uint32_t *cfg__context_hashes(const Cfg_Variable *ctx);
+static bool cfg__context_alloc(Cfg_Config *cfg, Cfg_Variable *ctx, size_t cap);
+
 // Cfg_Variable functions to add variable, free context or find variable
 // `cfg__context_find_variable` return -1 on error
 static void cfg__context_add_variable(Cfg_Config *cfg, Cfg_Lexer *lexer, Cfg_Variable *ctx, Cfg_Type type, char *name, char *value);
-static void cfg__context_free(Cfg_Variable *ctx);
+static void cfg__context_free(Cfg_Config *cfg, Cfg_Variable *ctx);
+
+// Append variable to context without redefinition check, returns NULL if there is no memory
+// `cap` is initial capacity of array/list/struct, 0 for INIT_VARIABLES_NUM
+static Cfg_Variable *cfg__context_append(Cfg_Config *cfg, Cfg_Variable *ctx, Cfg_Type type, const char *name, const char *value, size_t cap);
+// Remove inner variable `idx` of context with its inner variables, later variables are moved down
+static void cfg__context_remove(Cfg_Config *cfg, Cfg_Variable *ctx, size_t idx);
+
+// Replace value of scalar variable, old storage is reused when new value fits into it
+// Returns false if there is no memory, old value is kept then
+static bool cfg__variable_set_value(Cfg_Config *cfg, Cfg_Variable *var, const char *value);
+// Copy-on-write helpers
+// `cfg__context_unshare` copies borrowed array of variables of context, its inner variables
+// borrow their strings and arrays. `cfg__context_own` returns own copy of context `ctx` of clone
+// (which may point into base), arrays on its path are unshared. Both return false/NULL if
+// there is no memory or `ctx` has no copy in clone
+static bool cfg__context_unshare(Cfg_Config *cfg, Cfg_Variable *ctx);
+static Cfg_Variable *cfg__context_own(Cfg_Config *cfg, Cfg_Variable *ctx);
+// Set CFG_ERROR_CONFIG_SHARED if config has clones
+static bool cfg__frozen(Cfg_Config *cfg);
+// Overlay helpers
+// `cfg__path_find` finds variable by path of `len` bytes in context, NULL if there is none
+// `cfg__overlay_sync` changes stamp of overlay if generation of any layer changed
+static Cfg_Variable *cfg__path_find(Cfg_Variable *ctx, const char *path, size_t len);
+static Cfg_Variable *cfg__overlay_resolve(Cfg_Overlay *overlay, const char *path, size_t len);
+static void cfg__overlay_sync(Cfg_Overlay *overlay);
+static bool cfg__overlay_grow(Cfg_Overlay *overlay);
+
+// Environment layer helpers
+// `cfg__env_map_context` adds scalars of context to map under `name` (`len` bytes are used)
+// `cfg__env_convert` writes value of environment variable as text of `type` into `buf`,
+// returns NULL if it can not be converted
+static bool cfg__env_map_context(Cfg_Config *cfg, Cfg_Env_Map *map, Cfg_Variable *ctx, char *name, size_t len);
+static bool cfg__env_map_add(Cfg_Config *cfg, Cfg_Env_Map *map, const char *name, size_t len, Cfg_Variable *var);
+static Cfg_Variable *cfg__env_map_find(Cfg_Env_Map *map, const char *name, size_t len, uint32_t hash);
+static void cfg__env_map_free(Cfg_Config *cfg, Cfg_Env_Map *map);
+static const char *cfg__env_convert(Cfg_Type type, const char *value, char *buf, size_t size);
+static Cfg_Error_Type cfg__env_set(Cfg_Config *cfg, Cfg_Variable *var, const char *value);
+// Shortest of %.15g/%.17g which reads back as the same value
+static void cfg__format_double(char *buf, size_t size, double value);
+// Check if `value` is valid text of scalar of `type`: numbers are digits with optional leading `-`,
+// doubles may have one `.` and exponent, no spaces, `nan` or `inf`
+static bool cfg__value_valid(Cfg_Type type, const char *value);
+// Check if `name` can be written as identifier of config
+static bool cfg__name_valid(const char *name);
+// Reset error of config before operation, so error of failed call does not leak into next one
+static void cfg__err_clear(Cfg_Config *cfg);
+// Body of cfg_set_<type_name>
+static Cfg_Error_Type cfg__set(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, Cfg_Type type, const char *value);
+
+// Grow array of variables of context, vars_cap is doubled
+// Returns false if there is no memory
+static bool cfg__context_grow(Cfg_Config *cfg, Cfg_Variable *ctx);
+
+// Set `prev` of inner variables and their inner variables after context was moved
+// Inline names and values of inner variables are relinked too
+static void cfg__context_relink(Cfg_Variable *ctx);
+
+// Store name/value of variable inline if it fits into rest of inline_buf (`*used` bytes are taken),
+// otherwise duplicate it and add its size to `*counter`
+static char *cfg__variable_string(Cfg_Config *cfg, Cfg_Variable *var, const char *str, size_t *used,
+                                  unsigned char flag, size_t *counter);
+// Point inline name/value of variable to its inline_buf after variable was moved
+static void cfg__variable_relink_strings(Cfg_Variable *var);
+
+// Find interned copy of `str` or add one, returns NULL if there is no memory
+static char *cfg__intern(Cfg_Config *cfg, const char *str);
+static bool cfg__intern_grow(Cfg_Config *cfg);
+static void cfg__intern_free(Cfg_Config *cfg);
+
+// Check if memory belongs to block made by `cfg_config_compact`
+static bool cfg__in_block(Cfg_Config *cfg, const void *ptr);
+
+// Compaction helpers
+static void cfg__compact_measure(Cfg_Variable *ctx, size_t *nodes, size_t *count, size_t *strings);
+static void cfg__compact_copy(Cfg_Variable *dst, const Cfg_Variable *src, char **nodes, char **strings);
 static int cfg__context_find_variable(Cfg_Variable *ctx, const char *name);
+static int cfg__context_find_variable_n(Cfg_Variable *ctx, const char *name, size_t len, uint32_t hash);
+
+// Image helpers
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nodes_len;
+    uint32_t strings_size;
+} Cfg_Image_Header;
+
+#define CFG_IMAGE_MAGIC 0x49474643 // "CFGI"
+#define CFG_IMAGE_VERSION 1
+
+static void cfg__image_measure(const Cfg_Variable *ctx, size_t *nodes, size_t *strings);
+static uint32_t cfg__image_string(char *strings, uint32_t *offset, const char *str);
+static void cfg__image_copy(Cfg_Image_Node *nodes, uint32_t *hashes, char *strings, uint32_t idx,
+                            const Cfg_Variable *ctx, uint32_t *next_node, uint32_t *next_string);
+static uint32_t cfg__image_type_code(Cfg_Type type);
+// Point nodes/hashes/strings of image into data starting with `header`
+static void cfg__image_init(Cfg_Image *image, const Cfg_Image_Header *header, size_t size);
+#ifdef CFG_POSIX_IO
+// Check that image read from outside is a tree: every node has known type, inner nodes of
+// contexts are in range and belong to one context only, names/values point into strings
+// which end with zero. O(number of nodes)
+static bool cfg__image_valid(const Cfg_Image *image);
+// New memory file for shared image, -1 on error
+static int cfg__shared_fd(void);
+#endif
+static const Cfg_Image_Node *cfg__node(Cfg_Node node);
+static const char *cfg__node_value(Cfg_Node node, Cfg_Type type);
+
+// Record lookup result `i` of `name` in `ctx`
+// `type` is the requested type or CFG_TYPE_NONE if any type is fine
+static void cfg__telemetry_record(const Cfg_Variable *ctx, const char *name, int i, Cfg_Type type);
+
+#ifdef CFG_TELEMETRY
+// `cfg__telemetry_context_key` hashes address of global context (config) and path to `ctx`,
+// `cfg__telemetry_key` adds `name` to it. Both are O(depth of context)
+static uint64_t cfg__telemetry_context_key(const Cfg_Variable *ctx);
+static uint64_t cfg__telemetry_key(uint64_t ctx_key, const char *name);
+static Cfg_Telemetry_Slot *cfg__telemetry_find(const Cfg_Variable *ctx, const char *name, bool create);
+static int cfg__telemetry_compare(const void *a, const void *b);
+static void cfg__telemetry_dump_context(Cfg_Variable *ctx, FILE *out, char *path, size_t path_len,
+                                        Cfg_Telemetry_Slot **slots, size_t slots_len);
+#endif
 
 static Cfg_Lexer *cfg__buffer_tokenize(Cfg_Config *cfg, char *buffer);
 static Cfg_Lexer *cfg__stream_tokenize(Cfg_Config *cfg, FILE *stream);
 static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer);
+static int cfg__parse_statements(Cfg_Config *cfg, Cfg_Lexer *lexer);
+
+// Include helpers
+// `cfg__include_path` returns canonical path of `path` relative to directory of `file` (current
+// directory if `file` is NULL) allocated with CFG_MALLOC, NULL if file does not exist.
+// `cfg__include_stat` returns false if file can not be validated, its parse is not cached then
+static char *cfg__include_path(const char *file, const char *path);
+static bool cfg__include_stat(const char *path, Cfg_Include_Stamp *stamp);
+static bool cfg__include_stamp_equal(const Cfg_Include_Stamp *a, const Cfg_Include_Stamp *b);
+static void cfg__include_lock(void);
+static void cfg__include_unlock(void);
+// Cache functions, `cfg__include_find` and `cfg__include_drop` are called under lock
+// `cfg__include_drop` unlinks entry and returns it if it must be freed (after unlocking), NULL if it is referenced
+// `cfg__include_acquire` returns referenced entry parsed from file in state `stamp`, NULL if there is none
+// `cfg__include_store` adds parsed file to cache and returns referenced entry, `path` and `inc` are
+// owned by cache then (or freed if another thread stored the same file first), NULL if there is no memory
+static size_t cfg__include_find(const char *path, uint32_t hash);
+static Cfg_Include *cfg__include_drop(size_t idx);
+static void cfg__include_free(Cfg_Include *entry);
+static Cfg_Include *cfg__include_acquire(const char *path, const Cfg_Include_Stamp *stamp);
+static Cfg_Include *cfg__include_store(char *path, const Cfg_Include_Stamp *stamp, Cfg_Config *inc);
+static void cfg__include_release(Cfg_Include *entry);
+// Check if files included by parsed file did not change since it was parsed
+static bool cfg__include_valid(const Cfg_Config *inc);
+// Record file included by config, returns false if there is no memory
+static bool cfg__include_depend(Cfg_Config *cfg, const char *path, const Cfg_Include_Stamp *stamp);
+// Check if file is being parsed by thread (include cycle)
+static bool cfg__include_active(const char *path);
+// Push file of config on include stack if lexer has includes and load not cached included files
+// with one `cfg_load_files` call. Returns true if frame was pushed
+static bool cfg__include_begin(Cfg_Config *cfg, Cfg_Lexer *lexer, Cfg_Include_Frame *frame);
+static void cfg__include_end(Cfg_Include_Frame *frame);
+// Copy variables of included file into `ctx`, `token` is include token followed by path
+static void cfg__include(Cfg_Config *cfg, Cfg_Variable *ctx, const Cfg_Token *token);
+// Deep copy of inner variables of `src` appended to `dst` without redefinition check, returns false on error
+static bool cfg__context_copy(Cfg_Config *cfg, Cfg_Variable *dst, const Cfg_Variable *src);
+
+#ifdef CFG_POSIX_IO
+// Read file from `len` bytes until EOF with pread and load it into config
+// `buf` of `cap` bytes (may be NULL) is allocated by config and freed here, `fd` stays open
+static Cfg_Error_Type cfg__file_load_fd(Cfg_Config *cfg, int fd, const char *path, char *buf, size_t len, size_t cap);
+#endif
+
+#ifdef CFG_IO_URING
+// Minimal io_uring without liburing: rings are mapped once, submissions and
+// completions are synchronized with acquire/release on ring heads and tails
+typedef struct {
+    int fd;
+    unsigned entries;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_size;
+    size_t cq_size;
+    unsigned to_submit;
+} Cfg_Ring;
+
+static bool cfg__ring_init(Cfg_Ring *ring, unsigned entries);
+static void cfg__ring_free(Cfg_Ring *ring);
+// Next free submission entry (zeroed), NULL if ring is full
+static struct io_uring_sqe *cfg__ring_sqe(Cfg_Ring *ring);
+// Submit queued entries and wait until at least `wait` completions are available
+static bool cfg__ring_enter(Cfg_Ring *ring, unsigned wait);
+// Pop one completion, returns false if there is none
+static bool cfg__ring_cqe(Cfg_Ring *ring, uint64_t *user_data, int *res);
+// Pop one completion, waits for it if there is none. Returns false if ring failed
+static bool cfg__ring_wait(Cfg_Ring *ring, uint64_t *user_data, int *res);
+// Collect operations of batch still in flight (`busy`, all of `opcode`) after ring failed:
+// opened descriptors are stored in `fds`, closed ones are set to -1. Gives up after about
+// a second without completions, entries which stay busy may still be written by kernel
+static void cfg__ring_reap(Cfg_Ring *ring, unsigned opcode, int *fds, bool *busy, size_t len);
+// Load files in batches, ring is freed here. If ring fails, files of current batch are finished
+// synchronously and `*handled` is set to number of paths done, the rest is left to caller
+static size_t cfg__load_files_ring(Cfg_Ring *ring, Cfg_Config **cfgs, const char *const *paths, size_t count, size_t *handled);
+#endif
 
 // Private functions definition
 
+#ifdef CFG_STATS
+static uint64_t cfg__time_ns(void)
+{
+    // Monotonic clock is POSIX, timespec_get is C11, strict C99 has only processor time
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#elif defined(TIME_UTC)
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#else
+    return (uint64_t)((double)clock() * 1e9 / CLOCKS_PER_SEC);
+#endif
+}
+
+static void cfg__stats_memory(Cfg_Config *cfg, size_t old_size, size_t new_size)
+{
+    if (new_size > 0) {
+        cfg->stats.alloc_count++;
+        cfg->stats.alloc_bytes += new_size;
+    }
+    cfg->stats.memory = cfg->stats.memory - old_size + new_size;
+    if (cfg->stats.memory > cfg->stats.peak_memory) {
+        cfg->stats.peak_memory = cfg->stats.memory;
+    }
+}
+
+static void cfg__stats_load(Cfg_Config *cfg, Cfg_Lexer *lexer, uint64_t start, uint64_t tokenized)
+{
+    cfg->stats.tokenize_ns += tokenized - start;
+    cfg->stats.parse_ns += cfg__time_ns() - tokenized;
+    cfg->stats.bytes += lexer->bytes;
+    cfg->stats.tokens += lexer->tokens_len;
+}
+#endif
+
+static void *cfg__default_alloc(void *ctx, size_t size)
+{
+    (void)ctx;
+    return CFG_MALLOC(size);
+}
+
+static void *cfg__default_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    (void)ctx;
+    (void)old_size;
+    return CFG_REALLOC(ptr, new_size);
+}
+
+static void cfg__default_free(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    (void)size;
+    CFG_FREE(ptr);
+}
+
+static void *cfg__alloc(Cfg_Config *cfg, size_t size)
+{
+    void *ptr = cfg->allocator.alloc(cfg->allocator.ctx, size);
+    if (ptr) {
+        cfg->mem.total += size;
+        cfg->mem.allocations++;
+    }
+#ifdef CFG_STATS
+    if (ptr) cfg__stats_memory(cfg, 0, size);
+#endif
+    return ptr;
+}
+
+static void *cfg__realloc(Cfg_Config *cfg, void *ptr, size_t old_size, size_t new_size)
+{
+    void *new_ptr;
+    if (cfg->allocator.realloc) {
+        new_ptr = cfg->allocator.realloc(cfg->allocator.ctx, ptr, old_size, new_size);
+    } else {
+        new_ptr = cfg->allocator.alloc(cfg->allocator.ctx, new_size);
+        if (new_ptr && ptr) {
+            memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+            cfg->allocator.free(cfg->allocator.ctx, ptr, old_size);
+        }
+    }
+    if (new_ptr) {
+        cfg->mem.total = cfg->mem.total - old_size + new_size;
+        if (ptr == NULL) cfg->mem.allocations++;
+    }
+#ifdef CFG_STATS
+    if (new_ptr) cfg__stats_memory(cfg, old_size, new_size);
+#endif
+    return new_ptr;
+}
+
+static void cfg__free(Cfg_Config *cfg, void *ptr, size_t size)
+{
+    if (ptr == NULL) return;
+    cfg->allocator.free(cfg->allocator.ctx, ptr, size);
+    cfg->mem.total -= size;
+    cfg->mem.allocations--;
+#ifdef CFG_STATS
+    cfg__stats_memory(cfg, size, 0);
+#endif
+}
+
+static char *cfg__strdup(Cfg_Config *cfg, const char *str)
+{
+    size_t size = strlen(str) + 1;
+    char *dup = cfg__alloc(cfg, size);
+    if (dup) memcpy(dup, str, size);
+    return dup;
+}
+
 static Cfg_Lexer *cfg__lexer_create(Cfg_Config *cfg)
 {
-    Cfg_Lexer *lexer = malloc(sizeof(Cfg_Lexer));
+    Cfg_Lexer *lexer = cfg__alloc(cfg, sizeof(Cfg_Lexer));
+    if (!lexer) {
+        cfg->err.type = CFG_ERROR_NO_MEMORY;
+        sprintf(cfg->err.message, "Failed to allocate memory");
+        return NULL;
+    }
 
-    lexer->tokens = malloc(sizeof(Cfg_Token) * INIT_TOKENS_NUM);
-    lexer->stack.values = malloc(sizeof(char) * INIT_STACK_SIZE);
+    lexer->cfg = cfg;
+    lexer->tokens = cfg__alloc(cfg, sizeof(Cfg_Token) * INIT_TOKENS_NUM);
+    lexer->stack.values = cfg__alloc(cfg, sizeof(char) * INIT_STACK_SIZE);
+    lexer->tokens_len = 0;
+    lexer->tokens_cap = INIT_TOKENS_NUM;
+    lexer->stack.cap = INIT_STACK_SIZE;
 
-    if (!lexer || !lexer->tokens || !lexer->stack.values) {
+    if (!lexer->tokens || !lexer->stack.values) {
+        cfg__lexer_free(lexer);
         cfg->err.type = CFG_ERROR_NO_MEMORY;
         sprintf(cfg->err.message, "Failed to allocate memory");
         return NULL;
     }
     
     lexer->cur_token = 0;
-    lexer->tokens_len = 0;
-    lexer->tokens_cap = INIT_TOKENS_NUM;
 
     lexer->line = 1;
     lexer->column = 1;
@@ -270,35 +1184,63 @@ static Cfg_Lexer *cfg__lexer_create(Cfg_Config *cfg)
     lexer->comment_eol = false;
     lexer->comment = false;
 
-    lexer->stack.cap = INIT_STACK_SIZE;
     lexer->stack.len = 0;
 
+#ifdef CFG_STATS
+    lexer->bytes = 0;
+#endif
+
     return lexer;
 }
 
 static void cfg__lexer_free(Cfg_Lexer *lexer)
 {
-    if (lexer->stack.values != NULL) free(lexer->stack.values);
-    for (size_t i = 0; i < lexer->tokens_len; ++i) {
-        if (lexer->tokens[i].type > CFG_TOKEN_EOF && lexer->tokens[i].value != NULL) {
-            free(lexer->tokens[i].value);
+    Cfg_Config *cfg = lexer->cfg;
+    cfg__free(cfg, lexer->stack.values, sizeof(char) * lexer->stack.cap);
+    if (lexer->tokens != NULL) {
+        for (size_t i = 0; i < lexer->tokens_len; ++i) {
+            if (lexer->tokens[i].type > CFG_TOKEN_EOF && lexer->tokens[i].value != NULL) {
+                cfg__free(cfg, lexer->tokens[i].value, lexer->tokens[i].size);
+            }
         }
+        cfg__free(cfg, lexer->tokens, sizeof(Cfg_Token) * lexer->tokens_cap);
     }
-    if (lexer->tokens != NULL) free(lexer->tokens);
-    free(lexer);
+    cfg__free(cfg, lexer, sizeof(Cfg_Lexer));
+}
+
+static int cfg__lexer_getc(Cfg_Lexer *lexer, FILE *stream)
+{
+    int c = fgetc(stream);
+#ifdef CFG_STATS
+    if (c != EOF) lexer->bytes++;
+#else
+    (void)lexer;
+#endif
+    return c;
 }
 
-static void cfg__lexer_add_token(Cfg_Lexer *lexer, Cfg_Token_Type type, char *value)
+static void cfg__lexer_ungetc(Cfg_Lexer *lexer, int c, FILE *stream)
+{
+#ifdef CFG_STATS
+    if (c != EOF) lexer->bytes--;
+#else
+    (void)lexer;
+#endif
+    ungetc(c, stream);
+}
+
+static void cfg__lexer_add_token(Cfg_Lexer *lexer, Cfg_Token_Type type, char *value, size_t size)
 {
     if (lexer->tokens_len == lexer->tokens_cap) {
         lexer->tokens_cap *= 2;
-        lexer->tokens = realloc(lexer->tokens, sizeof(Cfg_Token) * lexer->tokens_cap);
+        lexer->tokens = cfg__realloc(lexer->cfg, lexer->tokens, sizeof(Cfg_Token) * lexer->tokens_cap / 2, sizeof(Cfg_Token) * lexer->tokens_cap);
     }
     
     size_t idx = lexer->tokens_len++;
     memset(&lexer->tokens[idx], 0, sizeof(Cfg_Token));
     lexer->tokens[idx].type = type;
     lexer->tokens[idx].value = value;
+    lexer->tokens[idx].size = size;
     lexer->tokens[idx].line = lexer->line;
     lexer->tokens[idx].column = lexer->column;
 }
@@ -308,9 +1250,14 @@ static void cfg__stack_add_char(Cfg_Lexer *lexer, char ch)
     Cfg_Stack *stack = &lexer->stack;
     if (stack->len == stack->cap) {
         stack->cap *= 2;
-        stack->values = realloc(stack->values, sizeof(char) * stack->cap);
+        stack->values = cfg__realloc(lexer->cfg, stack->values, sizeof(char) * stack->cap / 2, sizeof(char) * stack->cap);
     }
     stack->values[stack->len++] = ch;
+#ifdef CFG_STATS
+    if (stack->len > lexer->cfg->stats.max_depth) {
+        lexer->cfg->stats.max_depth = stack->len;
+    }
+#endif
 }
 
 static void cfg__stack_pop_char(Cfg_Lexer *lexer)
@@ -328,20 +1275,21 @@ static char cfg__stack_last_char(Cfg_Lexer *lexer)
     return stack->values[stack->len - 1];
 }
 
-static void cfg__string_add_char(char **str, size_t *cap, char ch)
+static void cfg__string_add_char(Cfg_Lexer *lexer, char **str, size_t *cap, char ch)
 {
     size_t len = strlen(*str);
     if (len + 2 > *cap) {
         *cap *= 2;
-        *str = realloc(*str, sizeof(char) * (*cap));
+        *str = cfg__realloc(lexer->cfg, *str, sizeof(char) * (*cap / 2), sizeof(char) * (*cap));
     }
     (*str)[len] = ch;
     (*str)[len + 1] = '\0';
 }
 
-static char *cfg__lexer_parse_string_buffer(Cfg_Lexer *lexer)
+static char *cfg__lexer_parse_string_buffer(Cfg_Lexer *lexer, size_t *size)
 {
-    char *str = malloc(sizeof(char) * INIT_STRING_SIZE);
+    char *str = cfg__alloc(lexer->cfg, sizeof(char) * INIT_STRING_SIZE);
+    if (!str) return NULL;
     str[0] = '\0';
     size_t cap = INIT_STRING_SIZE;
 
@@ -351,7 +1299,7 @@ static char *cfg__lexer_parse_string_buffer(Cfg_Lexer *lexer)
         if (*lexer->ch_current == '\\') {
             if (backslash) {
                 ch = '\\';
-                cfg__string_add_char(&str, &cap, ch);
+                cfg__string_add_char(lexer, &str, &cap, ch);
                 backslash = false;
                 lexer->ch_current++;
                 lexer->column++;
@@ -378,7 +1326,7 @@ static char *cfg__lexer_parse_string_buffer(Cfg_Lexer *lexer)
                 ch = '\'';
                 break;
             default:
-                cfg__string_add_char(&str, &cap, '\\');
+                cfg__string_add_char(lexer, &str, &cap, '\\');
                 ch = *lexer->ch_current;
                 break;
             }
@@ -386,11 +1334,13 @@ static char *cfg__lexer_parse_string_buffer(Cfg_Lexer *lexer)
         } else {
             ch = *lexer->ch_current;
         }
-        cfg__string_add_char(&str, &cap, ch);
+        cfg__string_add_char(lexer, &str, &cap, ch);
         lexer->ch_current++;
         lexer->column++;
     }
 
+    *size = cap;
+
     if (*lexer->ch_current == '\0') {
         str[0] = '\0';
         return str;
@@ -402,27 +1352,28 @@ static char *cfg__lexer_parse_string_buffer(Cfg_Lexer *lexer)
     return str;
 }
 
-static char *cfg__lexer_parse_string_stream(Cfg_Lexer *lexer, FILE *stream)
+static char *cfg__lexer_parse_string_stream(Cfg_Lexer *lexer, FILE *stream, size_t *size)
 {
     size_t cap = INIT_STRING_SIZE;
-    char *str = malloc(sizeof(char) * cap);
+    char *str = cfg__alloc(lexer->cfg, sizeof(char) * cap);
+    if (!str) return NULL;
     str[0] = '\0';
 
-    char c = fgetc(stream);
+    char c = cfg__lexer_getc(lexer, stream);
     char ch;
     bool backslash = false;
 
     while (c != EOF && (c != '"' || backslash)) {
         if (c == '\\') {
             if (backslash) {
-                cfg__string_add_char(&str, &cap, c);
+                cfg__string_add_char(lexer, &str, &cap, c);
                 backslash = false;
-                c = fgetc(stream);
+                c = cfg__lexer_getc(lexer, stream);
                 lexer->column++;
                 continue;
             }
             backslash = true;
-            c = fgetc(stream);
+            c = cfg__lexer_getc(lexer, stream);
             lexer->column++;
             continue;
         }
@@ -442,7 +1393,7 @@ static char *cfg__lexer_parse_string_stream(Cfg_Lexer *lexer, FILE *stream)
                 ch = '\'';
                 break;
             default:
-                cfg__string_add_char(&str, &cap, '\\');
+                cfg__string_add_char(lexer, &str, &cap, '\\');
                 ch = c;
                 break;
             }
@@ -450,11 +1401,13 @@ static char *cfg__lexer_parse_string_stream(Cfg_Lexer *lexer, FILE *stream)
         } else {
             ch = c;
         }
-        cfg__string_add_char(&str, &cap, ch);
-        c = fgetc(stream);
+        cfg__string_add_char(lexer, &str, &cap, ch);
+        c = cfg__lexer_getc(lexer, stream);
         lexer->column++;
     }
 
+    *size = cap;
+
     if (c == '\0') {
         str[0] = '\0';
         return str;
@@ -463,134 +1416,1138 @@ static char *cfg__lexer_parse_string_stream(Cfg_Lexer *lexer, FILE *stream)
     return str;
 }
 
-static void cfg__context_add_variable(Cfg_Config *cfg, Cfg_Lexer *lexer, Cfg_Variable *ctx, Cfg_Type type, char *name, char *value)
+static uint32_t cfg__hash(const char *name, size_t len)
 {
-    if (ctx->vars_len == ctx->vars_cap) {
-        ctx->vars_cap *= 2;
-        ctx->vars = realloc(ctx->vars, sizeof(Cfg_Variable) * ctx->vars_cap);
-        if (!ctx->vars) {
-            cfg->err.type = CFG_ERROR_NO_MEMORY;
-            sprintf(cfg->err.message, "Failed to allocate memory");
-            return;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t cfg__vars_size(size_t cap)
+{
+    // Rounded up so the next block in compacted config stays aligned
+    size_t size = CFG_SLOT_SIZE * cap;
+    return (size + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t);
+}
+
+static uint32_t *cfg__context_hashes(const Cfg_Variable *ctx)
+{
+    return (uint32_t *)(ctx->vars + ctx->vars_cap);
+}
+
+static bool cfg__context_alloc(Cfg_Config *cfg, Cfg_Variable *ctx, size_t cap)
+{
+    ctx->vars = cfg__alloc(cfg, cfg__vars_size(cap));
+    ctx->vars_len = 0;
+    if (!ctx->vars) {
+        ctx->vars_cap = 0;
+        return false;
+    }
+    ctx->vars_cap = cap;
+    cfg->mem.slack += cfg__vars_size(cap);
+    return true;
+}
+
+static bool cfg__in_block(Cfg_Config *cfg, const void *ptr)
+{
+    return cfg->block != NULL && (const char *)ptr >= cfg->block && (const char *)ptr < cfg->block + cfg->block_size;
+}
+
+static char *cfg__variable_string(Cfg_Config *cfg, Cfg_Variable *var, const char *str, size_t *used,
+                                  unsigned char flag, size_t *counter)
+{
+    size_t size = strlen(str) + 1;
+    if (*used + size <= CFG_INLINE_SIZE) {
+        char *res = var->inline_buf + *used;
+        memcpy(res, str, size);
+        *used += size;
+        var->string_flags |= flag;
+        return res;
+    }
+    *counter += size;
+    return cfg__strdup(cfg, str);
+}
+
+static bool cfg__intern_grow(Cfg_Config *cfg)
+{
+    Cfg_Intern *intern = &cfg->intern;
+    size_t cap = intern->cap > 0 ? intern->cap * 2 : INIT_INTERN_SLOTS;
+    char **slots = cfg__alloc(cfg, sizeof(char *) * cap);
+    if (!slots) return false;
+    memset(slots, 0, sizeof(char *) * cap);
+
+    for (size_t i = 0; i < intern->cap; ++i) {
+        char *str = intern->slots[i];
+        if (str == NULL) continue;
+        size_t j = cfg__hash(str, strlen(str)) & (cap - 1);
+        while (slots[j] != NULL) j = (j + 1) & (cap - 1);
+        slots[j] = str;
+    }
+
+    if (intern->slots != NULL) cfg__free(cfg, intern->slots, sizeof(char *) * intern->cap);
+    cfg->mem.interned += sizeof(char *) * (cap - intern->cap);
+    intern->slots = slots;
+    intern->cap = cap;
+    return true;
+}
+
+static char *cfg__intern(Cfg_Config *cfg, const char *str)
+{
+    Cfg_Intern *intern = &cfg->intern;
+    // Keep load factor under 3/4
+    if ((intern->len + 1) * 4 > intern->cap * 3 && !cfg__intern_grow(cfg)) return NULL;
+
+    size_t len = strlen(str);
+    size_t i = cfg__hash(str, len) & (intern->cap - 1);
+    while (intern->slots[i] != NULL) {
+        if (strcmp(intern->slots[i], str) == 0) {
+            intern->refs_size += len + 1;
+            return intern->slots[i];
         }
-        for (size_t i = 0; i < ctx->vars_len; ++i) {
-            ctx->vars[i].prev = ctx;
+        i = (i + 1) & (intern->cap - 1);
+    }
+
+    char *res = cfg__strdup(cfg, str);
+    if (!res) return NULL;
+    intern->slots[i] = res;
+    intern->len++;
+    intern->strings_size += len + 1;
+    intern->refs_size += len + 1;
+    cfg->mem.interned += len + 1;
+    return res;
+}
+
+static void cfg__intern_free(Cfg_Config *cfg)
+{
+    Cfg_Intern *intern = &cfg->intern;
+    for (size_t i = 0; i < intern->cap; ++i) {
+        if (intern->slots[i] != NULL) cfg__free(cfg, intern->slots[i], strlen(intern->slots[i]) + 1);
+    }
+    if (intern->slots != NULL) cfg__free(cfg, intern->slots, sizeof(char *) * intern->cap);
+    cfg->mem.interned = 0;
+    intern->slots = NULL;
+    intern->len = 0;
+    intern->cap = 0;
+    intern->strings_size = 0;
+    intern->refs_size = 0;
+}
+
+static void cfg__variable_relink_strings(Cfg_Variable *var)
+{
+    size_t offset = 0;
+    if (var->string_flags & CFG_INLINE_NAME) {
+        var->name = var->inline_buf;
+        offset = strlen(var->inline_buf) + 1;
+    }
+    if (var->string_flags & CFG_INLINE_VALUE) {
+        var->value = var->inline_buf + offset;
+    }
+}
+
+static void cfg__context_relink(Cfg_Variable *ctx)
+{
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        ctx->vars[i].prev = ctx;
+        cfg__variable_relink_strings(&ctx->vars[i]);
+        // Borrowed arrays keep pointing to variables of base
+        if (ctx->vars[i].string_flags & CFG_BORROWED_VARS) continue;
+        for (size_t j = 0; j < ctx->vars[i].vars_len; ++j) {
+            ctx->vars[i].vars[j].prev = &ctx->vars[i];
         }
     }
+}
 
-    ctx->vars[ctx->vars_len].type = type;
-    if (name != NULL) {
-        for (size_t i = 0; i < ctx->vars_len; ++i) {
-            if (strcmp(name, ctx->vars[i].name) == 0) {
-                cfg->err.type = CFG_ERROR_VARIABLE_REDEFINITION;
-                if (ctx->name != NULL) {
-                    snprintf(
-                        cfg->err.message, ERROR_MESSAGE_LEN,
-                        "Redefined variable `%s` inside `%s` at line:%lu, column:%lu",
-                        name, ctx->name, lexer->tokens[lexer->cur_token - 3].line, lexer->tokens[lexer->cur_token - 3].column
-                    );
-                } else {
-                    snprintf(
-                        cfg->err.message, ERROR_MESSAGE_LEN,
-                        "Redefined variable `%s` at line:%lu, column:%lu",
-                        name, lexer->tokens[lexer->cur_token - 3].line, lexer->tokens[lexer->cur_token - 3].column
-                    );
-                }
-                return;
-            }
+static bool cfg__context_grow(Cfg_Config *cfg, Cfg_Variable *ctx)
+{
+    size_t old_cap = ctx->vars_cap;
+    size_t new_cap = old_cap > 0 ? old_cap * 2 : INIT_VARIABLES_NUM;
+    Cfg_Variable *vars;
+
+    if (ctx->vars == NULL || cfg__in_block(cfg, ctx->vars)) {
+        // Arrays inside of compacted block can't be reallocated
+        vars = cfg__alloc(cfg, cfg__vars_size(new_cap));
+        if (!vars) return false;
+        if (ctx->vars_len > 0) {
+            memcpy(vars, ctx->vars, sizeof(Cfg_Variable) * ctx->vars_len);
+            memcpy(vars + new_cap, cfg__context_hashes(ctx), sizeof(uint32_t) * ctx->vars_len);
+        }
+        if (ctx->vars != NULL) cfg->mem.unused += cfg__vars_size(old_cap);
+    } else {
+        vars = cfg__realloc(cfg, ctx->vars, cfg__vars_size(old_cap), cfg__vars_size(new_cap));
+        if (!vars) return false;
+        memmove(vars + new_cap, vars + old_cap, sizeof(uint32_t) * ctx->vars_len);
+    }
+
+    ctx->vars = vars;
+    ctx->vars_cap = new_cap;
+    cfg->mem.slack += cfg__vars_size(new_cap) - cfg__vars_size(old_cap);
+    cfg__context_relink(ctx);
+    return true;
+}
+
+static void cfg__context_add_variable(Cfg_Config *cfg, Cfg_Lexer *lexer, Cfg_Variable *ctx, Cfg_Type type, char *name, char *value)
+{
+    if (name != NULL && cfg__context_find_variable(ctx, name) != -1) {
+        cfg->err.type = CFG_ERROR_VARIABLE_REDEFINITION;
+        if (ctx->name != NULL) {
+            snprintf(
+                cfg->err.message, ERROR_MESSAGE_LEN,
+                "Redefined variable `%s` inside `%s` at line:%lu, column:%lu",
+                name, ctx->name, lexer->tokens[lexer->cur_token - 3].line, lexer->tokens[lexer->cur_token - 3].column
+            );
+        } else {
+            snprintf(
+                cfg->err.message, ERROR_MESSAGE_LEN,
+                "Redefined variable `%s` at line:%lu, column:%lu",
+                name, lexer->tokens[lexer->cur_token - 3].line, lexer->tokens[lexer->cur_token - 3].column
+            );
         }
-        ctx->vars[ctx->vars_len].name = strdup(name);
+        return;
+    }
+    cfg__context_append(cfg, ctx, type, name, value, 0);
+}
+
+static Cfg_Variable *cfg__context_append(Cfg_Config *cfg, Cfg_Variable *ctx, Cfg_Type type, const char *name, const char *value, size_t cap)
+{
+    if ((ctx->string_flags & CFG_BORROWED_VARS && !cfg__context_unshare(cfg, ctx))
+        || (ctx->vars_len == ctx->vars_cap && !cfg__context_grow(cfg, ctx))) {
+        cfg->err.type = CFG_ERROR_NO_MEMORY;
+        sprintf(cfg->err.message, "Failed to allocate memory");
+        return NULL;
+    }
+
+    Cfg_Variable *var = &ctx->vars[ctx->vars_len];
+    size_t inline_used = 0;
+    var->type = type;
+    var->string_flags = 0;
+    cfg__context_hashes(ctx)[ctx->vars_len] = 0;
+    if (name != NULL) {
+        var->name = cfg__variable_string(cfg, var, name, &inline_used, CFG_INLINE_NAME, &cfg->mem.names);
+        cfg__context_hashes(ctx)[ctx->vars_len] = cfg__hash(name, strlen(name));
     } else {
-        ctx->vars[ctx->vars_len].name = NULL;
+        var->name = NULL;
     }
-    if (value != NULL) {
-        ctx->vars[ctx->vars_len].value = strdup(value);
+    if (value != NULL && cfg->intern.enabled && inline_used + strlen(value) + 1 > CFG_INLINE_SIZE) {
+        var->value = cfg__intern(cfg, value);
+        if (!var->value) {
+            cfg->err.type = CFG_ERROR_NO_MEMORY;
+            sprintf(cfg->err.message, "Failed to allocate memory");
+            return NULL;
+        }
+        var->string_flags |= CFG_SHARED_VALUE;
+    } else if (value != NULL) {
+        var->value = cfg__variable_string(cfg, var, value, &inline_used, CFG_INLINE_VALUE, &cfg->mem.values);
     } else {
-        ctx->vars[ctx->vars_len].value = NULL;
+        var->value = NULL;
     }
-    ctx->vars[ctx->vars_len].prev = ctx;
+    var->prev = ctx;
     if (type & CFG_TYPE_STRUCT || type & CFG_TYPE_ARRAY || type & CFG_TYPE_LIST) {
-        ctx->vars[ctx->vars_len].vars = malloc(sizeof(Cfg_Variable) * INIT_VARIABLES_NUM);
-        if (!ctx->vars[ctx->vars_len].vars) {
+        if (!cfg__context_alloc(cfg, var, cap > 0 ? cap : INIT_VARIABLES_NUM)) {
             cfg->err.type = CFG_ERROR_NO_MEMORY;
             sprintf(cfg->err.message, "Failed to allocate memory");
-            return;
+            return NULL;
         }
-        ctx->vars[ctx->vars_len].vars_cap = INIT_VARIABLES_NUM;
-        ctx->vars[ctx->vars_len].vars_len = 0;
     } else {
-        ctx->vars[ctx->vars_len].vars = NULL;
-        ctx->vars[ctx->vars_len].vars_cap = 0;
-        ctx->vars[ctx->vars_len].vars_len = 0;
+        var->vars = NULL;
+        var->vars_cap = 0;
+        var->vars_len = 0;
     }
     ctx->vars_len++;
+    cfg->mem.nodes += CFG_SLOT_SIZE;
+    cfg->mem.slack -= CFG_SLOT_SIZE;
+
+#ifdef CFG_STATS
+    switch (type) {
+    case CFG_TYPE_INT: cfg->stats.ints++; break;
+    case CFG_TYPE_DOUBLE: cfg->stats.doubles++; break;
+    case CFG_TYPE_BOOL: cfg->stats.bools++; break;
+    case CFG_TYPE_STRING: cfg->stats.strings++; break;
+    case CFG_TYPE_ARRAY: cfg->stats.arrays++; break;
+    case CFG_TYPE_LIST: cfg->stats.lists++; break;
+    case CFG_TYPE_STRUCT: cfg->stats.structs++; break;
+    default: break;
+    }
+#endif
+    return var;
 }
 
-static int cfg__context_find_variable(Cfg_Variable *ctx, const char *name)
+static bool cfg__variable_set_value(Cfg_Config *cfg, Cfg_Variable *var, const char *value)
 {
-    for (size_t i = 0; i < ctx->vars_len; ++i) {
-        if (strcmp(name, ctx->vars[i].name) == 0) {
-            return i;
+    char *old = var->value;
+    unsigned char old_flags = var->string_flags;
+    size_t size = strlen(value) + 1;
+    size_t old_size = strlen(old) + 1;
+    size_t used = old_flags & CFG_INLINE_NAME ? strlen(var->name) + 1 : 0;
+    bool borrowed = old_flags & CFG_BORROWED_VALUE;
+    bool in_block = !(old_flags & (CFG_INLINE_VALUE | CFG_SHARED_VALUE)) && !borrowed && cfg__in_block(cfg, old);
+    bool owned = !(old_flags & (CFG_INLINE_VALUE | CFG_SHARED_VALUE)) && !borrowed && !in_block;
+
+    // Rewrite in place: inline value which still fits, value inside of compacted block
+    // which is not longer or owned copy of the same size
+    if ((old_flags & CFG_INLINE_VALUE && used + size <= CFG_INLINE_SIZE)
+        || (in_block && size <= old_size) || (owned && size == old_size)) {
+        memmove(old, value, size);
+        if (in_block) {
+            cfg->mem.values -= old_size - size;
+            cfg->mem.unused += old_size - size;
         }
+        return true;
     }
-    return -1;
+
+    // Owned copy is resized unless value is going inline or is interned
+    // (`value` may point into old copy, realloc is skipped then)
+    bool aliased = value >= old && value < old + old_size;
+    if (owned && !aliased && used + size > CFG_INLINE_SIZE && !cfg->intern.enabled) {
+        char *res = cfg__realloc(cfg, old, old_size, size);
+        if (!res) return false;
+        memcpy(res, value, size);
+        cfg->mem.values -= old_size;
+        cfg->mem.values += size;
+        var->value = res;
+        return true;
+    }
+
+    // New storage is filled before old one is released, same rules as for loaded values
+    char *res;
+    var->string_flags &= ~(CFG_INLINE_VALUE | CFG_SHARED_VALUE | CFG_BORROWED_VALUE);
+    if (used + size > CFG_INLINE_SIZE && cfg->intern.enabled) {
+        res = cfg__intern(cfg, value);
+        if (res) var->string_flags |= CFG_SHARED_VALUE;
+    } else {
+        res = cfg__variable_string(cfg, var, value, &used, CFG_INLINE_VALUE, &cfg->mem.values);
+    }
+    if (!res) {
+        if (!(var->string_flags & CFG_INLINE_VALUE) && !cfg->intern.enabled) cfg->mem.values -= size;
+        var->string_flags = old_flags;
+        return false;
+    }
+
+    if (old_flags & CFG_SHARED_VALUE) {
+        cfg->intern.refs_size -= old_size;
+    } else if (in_block) {
+        cfg->mem.values -= old_size;
+        cfg->mem.unused += old_size;
+    } else if (owned) {
+        cfg->mem.values -= old_size;
+        cfg__free(cfg, old, old_size);
+    }
+    var->value = res;
+    return true;
 }
 
-static void cfg__context_free(Cfg_Variable *ctx)
+static void cfg__context_remove(Cfg_Config *cfg, Cfg_Variable *ctx, size_t idx)
 {
-    if (ctx->vars != NULL) {
-        for (size_t i = 0; i < ctx->vars_len; ++i) {
-            cfg__context_free(&ctx->vars[i]);
+    cfg__context_free(cfg, &ctx->vars[idx]);
+
+    // Later variables and their hashes are moved down to keep order of context
+    size_t tail = ctx->vars_len - idx - 1;
+    uint32_t *hashes = cfg__context_hashes(ctx);
+    memmove(&ctx->vars[idx], &ctx->vars[idx + 1], sizeof(Cfg_Variable) * tail);
+    memmove(&hashes[idx], &hashes[idx + 1], sizeof(uint32_t) * tail);
+    ctx->vars_len--;
+    cfg->mem.nodes -= CFG_SLOT_SIZE;
+    cfg->mem.slack += CFG_SLOT_SIZE;
+    for (size_t i = idx; i < ctx->vars_len; ++i) {
+        cfg__variable_relink_strings(&ctx->vars[i]);
+        if (ctx->vars[i].string_flags & CFG_BORROWED_VARS) continue;
+        for (size_t j = 0; j < ctx->vars[i].vars_len; ++j) {
+            ctx->vars[i].vars[j].prev = &ctx->vars[i];
         }
-        free(ctx->vars);
     }
-    if (ctx->name != NULL) free(ctx->name);
-    if (ctx->value != NULL) free(ctx->value);
 }
 
-static Cfg_Lexer *cfg__buffer_tokenize(Cfg_Config *cfg, char *buffer)
+static bool cfg__context_unshare(Cfg_Config *cfg, Cfg_Variable *ctx)
 {
-    Cfg_Lexer *lexer = cfg__lexer_create(cfg);
-    lexer->ch_current = buffer;
+    // Exact size, clones usually change a few values and inserts grow it by doubling
+    size_t cap = ctx->vars_len > 0 ? ctx->vars_len : INIT_VARIABLES_NUM;
+    Cfg_Variable *vars = cfg__alloc(cfg, cfg__vars_size(cap));
+    if (!vars) return false;
+    if (ctx->vars_len > 0) {
+        memcpy(vars, ctx->vars, sizeof(Cfg_Variable) * ctx->vars_len);
+        memcpy(vars + cap, cfg__context_hashes(ctx), sizeof(uint32_t) * ctx->vars_len);
+    }
+    ctx->vars = vars;
+    ctx->vars_cap = cap;
+    ctx->string_flags &= ~CFG_BORROWED_VARS;
+    cfg->mem.nodes += CFG_SLOT_SIZE * ctx->vars_len;
+    cfg->mem.slack += cfg__vars_size(cap) - CFG_SLOT_SIZE * ctx->vars_len;
 
-    while (*lexer->ch_current != '\0') {
-        if (*lexer->ch_current == '\n') {
-            lexer->comment_eol = false;
-            lexer->line++;
-            lexer->column = 1;
-            lexer->ch_current++;
-            continue;
+    // Only copied variables are relinked, inner variables of base are never written
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        Cfg_Variable *var = &vars[i];
+        var->prev = ctx;
+        cfg__variable_relink_strings(var);
+        if (var->name != NULL && !(var->string_flags & CFG_INLINE_NAME)) var->string_flags |= CFG_BORROWED_NAME;
+        if (var->value != NULL && !(var->string_flags & CFG_INLINE_VALUE)) {
+            var->string_flags &= ~CFG_SHARED_VALUE;
+            var->string_flags |= CFG_BORROWED_VALUE;
         }
+        if (var->vars != NULL) var->string_flags |= CFG_BORROWED_VARS;
+    }
+    return true;
+}
 
-        if (*lexer->ch_current == '/') {
-            lexer->ch_current++;
-            lexer->column++;
-            if (*lexer->ch_current == '/') {
-                lexer->comment_eol = true;
-                lexer->ch_current++;
-                lexer->column++;
-                continue;
-            } else if (*lexer->ch_current == '*') {
-                lexer->comment = true;
-                lexer->ch_current++;
-                lexer->column++;
-                continue;
-            }
-        }
+static Cfg_Variable *cfg__context_own(Cfg_Config *cfg, Cfg_Variable *ctx)
+{
+    if (cfg->base == NULL) return ctx;
 
-        if (*lexer->ch_current == '*' && lexer->comment) {
-            lexer->ch_current++;
-            lexer->column++;
-            if (*lexer->ch_current == '/') {
-                lexer->comment = false;
-                lexer->ch_current++;
-                lexer->column++;
-                continue;
-            }
+    Cfg_Variable *own;
+    if (ctx->prev == NULL) {
+        own = &cfg->global;
+    } else {
+        Cfg_Variable *parent = cfg__context_own(cfg, ctx->prev);
+        if (!parent) return NULL;
+        own = NULL;
+        if (parent == ctx->prev) {
+            // Parent is own copy, so is the array `ctx` lives in
+            own = ctx;
+        } else if (ctx->name != NULL) {
+            int i = cfg__context_find_variable(parent, ctx->name);
+            if (i != -1) own = &parent->vars[i];
+        } else {
+            size_t idx = ctx - ctx->prev->vars;
+            if (idx < parent->vars_len) own = &parent->vars[idx];
         }
-
-        if (lexer->comment || lexer->comment_eol) {
-            lexer->ch_current++;
+        if (!own) {
+            cfg->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+            snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Context was removed from clone");
+            return NULL;
+        }
+    }
+    if (own->string_flags & CFG_BORROWED_VARS && !cfg__context_unshare(cfg, own)) {
+        cfg->err.type = CFG_ERROR_NO_MEMORY;
+        sprintf(cfg->err.message, "Failed to allocate memory");
+        return NULL;
+    }
+    return own;
+}
+
+static bool cfg__frozen(Cfg_Config *cfg)
+{
+    if (cfg->clones == 0) return false;
+
+    cfg->err.type = CFG_ERROR_CONFIG_SHARED;
+    snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Config is shared with %lu clones", (unsigned long)cfg->clones);
+    return true;
+}
+
+static Cfg_Variable *cfg__path_find(Cfg_Variable *ctx, const char *path, size_t len)
+{
+    const char *end = path + len;
+    while (ctx != NULL) {
+        const char *dot = memchr(path, '.', end - path);
+        size_t n = dot ? (size_t)(dot - path) : (size_t)(end - path);
+        if (ctx->type == CFG_TYPE_ARRAY || ctx->type == CFG_TYPE_LIST) {
+            size_t idx = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (!isdigit((unsigned char)path[i])) return NULL;
+                idx = idx * 10 + (size_t)(path[i] - '0');
+            }
+            ctx = n > 0 && idx < ctx->vars_len ? &ctx->vars[idx] : NULL;
+        } else if (ctx->type == CFG_TYPE_STRUCT) {
+            int i = cfg__context_find_variable_n(ctx, path, n, cfg__hash(path, n));
+            ctx = i != -1 ? &ctx->vars[i] : NULL;
+        } else {
+            return NULL;
+        }
+        if (!dot) return ctx;
+        path = dot + 1;
+    }
+    return NULL;
+}
+
+static Cfg_Variable *cfg__overlay_resolve(Cfg_Overlay *overlay, const char *path, size_t len)
+{
+    for (size_t i = overlay->layers_len; i-- > 0;) {
+        Cfg_Variable *var = cfg__path_find(&overlay->layers[i]->global, path, len);
+        if (var != NULL) return var;
+    }
+    return NULL;
+}
+
+static void cfg__overlay_sync(Cfg_Overlay *overlay)
+{
+    for (size_t i = 0; i < overlay->layers_len; ++i) {
+        if (overlay->generations[i] != overlay->layers[i]->generation) {
+            overlay->generations[i] = overlay->layers[i]->generation;
+            overlay->stamp++;
+        }
+    }
+}
+
+static bool cfg__overlay_grow(Cfg_Overlay *overlay)
+{
+    size_t cap = overlay->cache_cap > 0 ? overlay->cache_cap * 2 : INIT_OVERLAY_SLOTS;
+    Cfg_Overlay_Entry *cache = CFG_MALLOC(sizeof(Cfg_Overlay_Entry) * cap);
+    if (!cache) return false;
+    memset(cache, 0, sizeof(Cfg_Overlay_Entry) * cap);
+
+    for (size_t i = 0; i < overlay->cache_cap; ++i) {
+        Cfg_Overlay_Entry *entry = &overlay->cache[i];
+        if (entry->path == NULL) continue;
+        size_t j = entry->hash & (cap - 1);
+        while (cache[j].path != NULL) j = (j + 1) & (cap - 1);
+        cache[j] = *entry;
+    }
+
+    CFG_FREE(overlay->cache);
+    overlay->cache = cache;
+    overlay->cache_cap = cap;
+    return true;
+}
+
+static void cfg__format_double(char *buf, size_t size, double value)
+{
+    snprintf(buf, size, "%.15g", value);
+    if (strtod(buf, NULL) != value) snprintf(buf, size, "%.17g", value);
+}
+
+static bool cfg__env_map_add(Cfg_Config *cfg, Cfg_Env_Map *map, const char *name, size_t len, Cfg_Variable *var)
+{
+    if ((map->len + 1) * 4 > map->cap * 3) {
+        size_t cap = map->cap > 0 ? map->cap * 2 : INIT_ENV_SLOTS;
+        Cfg_Env_Slot *slots = cfg__alloc(cfg, sizeof(Cfg_Env_Slot) * cap);
+        if (!slots) return false;
+        memset(slots, 0, sizeof(Cfg_Env_Slot) * cap);
+        for (size_t i = 0; i < map->cap; ++i) {
+            if (map->slots[i].name == NULL) continue;
+            size_t j = map->slots[i].hash & (cap - 1);
+            while (slots[j].name != NULL) j = (j + 1) & (cap - 1);
+            slots[j] = map->slots[i];
+        }
+        if (map->slots != NULL) cfg__free(cfg, map->slots, sizeof(Cfg_Env_Slot) * map->cap);
+        map->slots = slots;
+        map->cap = cap;
+    }
+
+    // Upper layers are mapped first and win
+    uint32_t hash = cfg__hash(name, len);
+    if (cfg__env_map_find(map, name, len, hash) != NULL) return true;
+    size_t i = hash & (map->cap - 1);
+    while (map->slots[i].name != NULL) i = (i + 1) & (map->cap - 1);
+    map->slots[i].name = cfg__alloc(cfg, len + 1);
+    if (!map->slots[i].name) return false;
+    memcpy(map->slots[i].name, name, len);
+    map->slots[i].name[len] = '\0';
+    map->slots[i].hash = hash;
+    map->slots[i].var = var;
+    map->len++;
+    return true;
+}
+
+static Cfg_Variable *cfg__env_map_find(Cfg_Env_Map *map, const char *name, size_t len, uint32_t hash)
+{
+    if (map->cap == 0) return NULL;
+
+    size_t i = hash & (map->cap - 1);
+    while (map->slots[i].name != NULL) {
+        Cfg_Env_Slot *slot = &map->slots[i];
+        if (slot->hash == hash && strncmp(slot->name, name, len) == 0 && slot->name[len] == '\0') return slot->var;
+        i = (i + 1) & (map->cap - 1);
+    }
+    return NULL;
+}
+
+static void cfg__env_map_free(Cfg_Config *cfg, Cfg_Env_Map *map)
+{
+    for (size_t i = 0; i < map->cap; ++i) {
+        if (map->slots[i].name != NULL) cfg__free(cfg, map->slots[i].name, strlen(map->slots[i].name) + 1);
+    }
+    if (map->slots != NULL) cfg__free(cfg, map->slots, sizeof(Cfg_Env_Slot) * map->cap);
+}
+
+static bool cfg__env_map_context(Cfg_Config *cfg, Cfg_Env_Map *map, Cfg_Variable *ctx, char *name, size_t len)
+{
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        Cfg_Variable *var = &ctx->vars[i];
+        size_t var_len = len + (len > 0 ? 2 : 0) + strlen(var->name);
+        if (var_len >= ENV_NAME_MAX) continue;
+        char *ch = name + len;
+        if (len > 0) {
+            *ch++ = '_';
+            *ch++ = '_';
+        }
+        for (const char *src = var->name; *src != '\0'; ++src) {
+            *ch++ = isalnum((unsigned char)*src) ? (char)toupper((unsigned char)*src) : '_';
+        }
+
+        if (var->type == CFG_TYPE_STRUCT) {
+            if (!cfg__env_map_context(cfg, map, var, name, var_len)) return false;
+        } else if (var->type & (CFG_TYPE_INT | CFG_TYPE_DOUBLE | CFG_TYPE_BOOL | CFG_TYPE_STRING)) {
+            if (!cfg__env_map_add(cfg, map, name, var_len, var)) return false;
+        }
+    }
+    return true;
+}
+
+static const char *cfg__env_convert(Cfg_Type type, const char *value, char *buf, size_t size)
+{
+    static const char *bools[] = {"true", "false", "yes", "no", "on", "off", "1", "0"};
+    // Numbers are checked with the rules of cfg_insert, then written in canonical form
+    switch (type) {
+    case CFG_TYPE_INT:
+        if (!cfg__value_valid(type, value)) return NULL;
+        snprintf(buf, size, "%ld", strtol(value, NULL, 10));
+        return buf;
+    case CFG_TYPE_DOUBLE:
+        if (!cfg__value_valid(type, value)) return NULL;
+        cfg__format_double(buf, size, strtod(value, NULL));
+        return buf;
+    case CFG_TYPE_BOOL:
+        for (size_t i = 0; i < sizeof(bools) / sizeof(bools[0]); ++i) {
+            size_t j = 0;
+            while (bools[i][j] != '\0' && tolower((unsigned char)value[j]) == bools[i][j]) j++;
+            if (bools[i][j] == '\0' && value[j] == '\0') return i % 2 == 0 ? "true" : "false";
+        }
+        return NULL;
+    default:
+        return value;
+    }
+}
+
+static Cfg_Error_Type cfg__env_set(Cfg_Config *cfg, Cfg_Variable *var, const char *value)
+{
+    // Structs on path of `var` are found or added in `cfg`, from global context down
+    Cfg_Variable *path[ENV_NAME_MAX / 3 + 1];
+    size_t depth = 0;
+    for (Cfg_Variable *ctx = var->prev; ctx->prev != NULL; ctx = ctx->prev) path[depth++] = ctx;
+
+    Cfg_Variable *ctx = &cfg->global;
+    while (depth-- > 0) {
+        int i = cfg__context_find_variable(ctx, path[depth]->name);
+        Cfg_Variable *inner = i != -1 ? &ctx->vars[i] : cfg_insert(cfg, ctx, CFG_TYPE_STRUCT, path[depth]->name, NULL);
+        if (inner == NULL) return cfg->err.type;
+        ctx = inner;
+    }
+    return cfg__set(cfg, ctx, var->name, var->type, value);
+}
+
+static bool cfg__value_valid(Cfg_Type type, const char *value)
+{
+    const char *p = value;
+    switch (type) {
+    case CFG_TYPE_INT:
+    case CFG_TYPE_DOUBLE:
+        if (*p == '-') p++;
+        if (!isdigit((unsigned char)*p)) return false;
+        while (isdigit((unsigned char)*p)) p++;
+        if (type == CFG_TYPE_INT) {
+            errno = 0;
+            long int_value = strtol(value, NULL, 10);
+            return *p == '\0' && errno == 0 && int_value >= INT_MIN && int_value <= INT_MAX;
+        }
+        if (*p == '.') {
+            p++;
+            while (isdigit((unsigned char)*p)) p++;
+        }
+        if (*p == 'e' || *p == 'E') {
+            p++;
+            if (*p == '-' || *p == '+') p++;
+            if (!isdigit((unsigned char)*p)) return false;
+            while (isdigit((unsigned char)*p)) p++;
+        }
+        return *p == '\0' && isfinite(strtod(value, NULL));
+    case CFG_TYPE_BOOL: return strcmp(value, "true") == 0 || strcmp(value, "false") == 0;
+    case CFG_TYPE_STRING: return true;
+    default: return false;
+    }
+}
+
+static bool cfg__name_valid(const char *name)
+{
+    if (*name == '\0' || *name == '"' || *name == '/' || isdigit((unsigned char)*name)) return false;
+    if (strcmp(name, "true") == 0 || strcmp(name, "false") == 0 || strcmp(name, "@include") == 0) return false;
+    for (const char *p = name; *p; p++) {
+        if (isspace((unsigned char)*p) || strchr("=;,[](){}", *p) != NULL) return false;
+    }
+    return true;
+}
+
+static void cfg__err_clear(Cfg_Config *cfg)
+{
+    cfg->err.type = CFG_ERROR_NONE;
+    cfg->err.message[0] = '\0';
+}
+
+static Cfg_Error_Type cfg__set(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, Cfg_Type type, const char *value)
+{
+    cfg__err_clear(cfg);
+    int i = cfg__context_find_variable(ctx, name);
+    if (i == -1) {
+        return cfg_insert(cfg, ctx, type, name, value) != NULL ? CFG_ERROR_NONE : cfg->err.type;
+    }
+
+    if (ctx->vars[i].type != type) {
+        cfg->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Variable `%s` has another type", name);
+        return cfg->err.type;
+    }
+    if (!cfg__value_valid(type, value)) {
+        cfg->err.type = CFG_ERROR_VARIABLE_PARSE;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Invalid value of variable `%s`", name);
+        return cfg->err.type;
+    }
+
+    if (cfg__frozen(cfg)) return cfg->err.type;
+    ctx = cfg__context_own(cfg, ctx);
+    if (!ctx) return cfg->err.type;
+    cfg->generation++;
+
+    if (!cfg__variable_set_value(cfg, &ctx->vars[i], value)) {
+        cfg->err.type = CFG_ERROR_NO_MEMORY;
+        sprintf(cfg->err.message, "Failed to allocate memory");
+        return cfg->err.type;
+    }
+
+    return CFG_ERROR_NONE;
+}
+
+static int cfg__context_find_variable(Cfg_Variable *ctx, const char *name)
+{
+    size_t len = strlen(name);
+    return cfg__context_find_variable_n(ctx, name, len, cfg__hash(name, len));
+}
+
+static int cfg__context_find_variable_n(Cfg_Variable *ctx, const char *name, size_t len, uint32_t hash)
+{
+    if (ctx->vars_len == 0) return -1;
+
+    const uint32_t *hashes = cfg__context_hashes(ctx);
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        const char *var_name = ctx->vars[i].name;
+        if (hashes[i] == hash && var_name != NULL && strncmp(name, var_name, len) == 0 && var_name[len] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef CFG_TELEMETRY
+static uint64_t cfg__telemetry_context_key(const Cfg_Variable *ctx)
+{
+    // FNV-1a of path from `ctx` up, names end with '.', element indexes with '['
+    uint64_t key = 14695981039346656037ULL;
+    for (; ctx->prev != NULL; ctx = ctx->prev) {
+        if (ctx->name != NULL) {
+            for (const char *ch = ctx->name; *ch != '\0'; ++ch) {
+                key ^= (unsigned char)*ch;
+                key *= 1099511628211ULL;
+            }
+            key ^= '.';
+        } else {
+            key ^= (uint64_t)(ctx - ctx->prev->vars);
+            key *= 1099511628211ULL;
+            key ^= '[';
+        }
+        key *= 1099511628211ULL;
+    }
+    // Global context is embedded in config, its address does not change
+    key ^= (uint64_t)(uintptr_t)ctx;
+    key *= 0x9e3779b97f4a7c15ULL;
+    return key ^ key >> 32;
+}
+
+static uint64_t cfg__telemetry_key(uint64_t ctx_key, const char *name)
+{
+    uint64_t key = ctx_key;
+    for (const char *ch = name; *ch != '\0'; ++ch) {
+        key ^= (unsigned char)*ch;
+        key *= 1099511628211ULL;
+    }
+    key *= 0x9e3779b97f4a7c15ULL;
+    key ^= key >> 32;
+    return key != 0 ? key : 1;
+}
+
+static Cfg_Telemetry_Slot *cfg__telemetry_find(const Cfg_Variable *ctx, const char *name, bool create)
+{
+    uint64_t ctx_key = cfg__telemetry_context_key(ctx);
+    uint64_t key = cfg__telemetry_key(ctx_key, name);
+    size_t mask = CFG_TELEMETRY_SLOTS - 1;
+
+    for (size_t probe = 0; probe < CFG_TELEMETRY_SLOTS; ++probe) {
+        Cfg_Telemetry_Slot *slot = &cfg__telemetry_slots[(key + probe) & mask];
+        uint64_t cur = cfg__atomic_load(&slot->key, CFG_ACQUIRE);
+
+        if (cur == 0) {
+            if (!create) return NULL;
+            uint64_t expected = 0;
+            if (cfg__atomic_cas(&slot->key, &expected, key)) {
+                slot->ctx_key = ctx_key;
+                strncpy(slot->name, name, CFG_TELEMETRY_NAME_LEN - 1);
+                slot->name[CFG_TELEMETRY_NAME_LEN - 1] = '\0';
+                cfg__atomic_store(&slot->ready, true, CFG_RELEASE);
+                return slot;
+            }
+            cur = expected;
+        }
+
+        if (cur == key) return slot;
+    }
+
+    return NULL;
+}
+
+static int cfg__telemetry_compare(const void *a, const void *b)
+{
+    uint64_t x = (*(Cfg_Telemetry_Slot *const *)a)->ctx_key;
+    uint64_t y = (*(Cfg_Telemetry_Slot *const *)b)->ctx_key;
+    return (x > y) - (x < y);
+}
+
+static void cfg__telemetry_dump_context(Cfg_Variable *ctx, FILE *out, char *path, size_t path_len,
+                                        Cfg_Telemetry_Slot **slots, size_t slots_len)
+{
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        Cfg_Variable *var = &ctx->vars[i];
+        int len;
+        if (var->name != NULL) {
+            len = snprintf(path + path_len, ERROR_MESSAGE_LEN - path_len, "%s%s", path_len > 0 ? "." : "", var->name);
+        } else {
+            len = snprintf(path + path_len, ERROR_MESSAGE_LEN - path_len, "[%lu]", i);
+        }
+        size_t child_len = path_len + (size_t)len;
+        if (child_len >= ERROR_MESSAGE_LEN) child_len = ERROR_MESSAGE_LEN - 1;
+
+        if (var->name != NULL) {
+            Cfg_Telemetry_Slot *slot = cfg__telemetry_find(ctx, var->name, false);
+            fprintf(out, "%12llu %12llu %12llu  %s\n",
+                    slot ? (unsigned long long)cfg__atomic_load(&slot->hits, CFG_RELAXED) : 0ULL,
+                    slot ? (unsigned long long)cfg__atomic_load(&slot->misses, CFG_RELAXED) : 0ULL,
+                    slot ? (unsigned long long)cfg__atomic_load(&slot->wrong_type, CFG_RELAXED) : 0ULL,
+                    path);
+        }
+
+        if (var->vars != NULL) {
+            cfg__telemetry_dump_context(var, out, path, child_len, slots, slots_len);
+        }
+        path[path_len] = '\0';
+    }
+
+    // Keys looked up in this context but not defined in it
+    // `slots` are sorted by context key, find the first one of this context
+    uint64_t ctx_key = cfg__telemetry_context_key(ctx);
+    size_t lo = 0, hi = slots_len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (slots[mid]->ctx_key < ctx_key) lo = mid + 1;
+        else hi = mid;
+    }
+    for (size_t i = lo; i < slots_len && slots[i]->ctx_key == ctx_key; ++i) {
+        if (cfg__context_find_variable(ctx, slots[i]->name) != -1) continue;
+        fprintf(out, "%12llu %12llu %12llu  %s%s%s (undefined)\n",
+                (unsigned long long)cfg__atomic_load(&slots[i]->hits, CFG_RELAXED),
+                (unsigned long long)cfg__atomic_load(&slots[i]->misses, CFG_RELAXED),
+                (unsigned long long)cfg__atomic_load(&slots[i]->wrong_type, CFG_RELAXED),
+                path, path_len > 0 ? "." : "", slots[i]->name);
+    }
+}
+#endif
+
+static void cfg__telemetry_record(const Cfg_Variable *ctx, const char *name, int i, Cfg_Type type)
+{
+#ifdef CFG_TELEMETRY
+    Cfg_Telemetry_Slot *slot = cfg__telemetry_find(ctx, name, true);
+    if (!slot) {
+        cfg__atomic_add(&cfg__telemetry_dropped, 1);
+        return;
+    }
+
+    if (i == -1) {
+        cfg__atomic_add(&slot->misses, 1);
+    } else if (type != CFG_TYPE_NONE && ctx->vars[i].type != type) {
+        cfg__atomic_add(&slot->wrong_type, 1);
+    } else {
+        cfg__atomic_add(&slot->hits, 1);
+    }
+#else
+    (void)ctx;
+    (void)name;
+    (void)i;
+    (void)type;
+#endif
+}
+
+static void cfg__context_free(Cfg_Config *cfg, Cfg_Variable *ctx)
+{
+    // Memory inside of compacted block is released with the block, borrowed memory with base
+    if (ctx->vars != NULL && !(ctx->string_flags & CFG_BORROWED_VARS)) {
+        for (size_t i = 0; i < ctx->vars_len; ++i) {
+            cfg__context_free(cfg, &ctx->vars[i]);
+        }
+        size_t size = cfg__vars_size(ctx->vars_cap);
+        if (cfg__in_block(cfg, ctx->vars)) {
+            cfg->mem.unused += size;
+        } else {
+            cfg__free(cfg, ctx->vars, size);
+        }
+        cfg->mem.nodes -= CFG_SLOT_SIZE * ctx->vars_len;
+        cfg->mem.slack -= size - CFG_SLOT_SIZE * ctx->vars_len;
+    }
+    if (ctx->name != NULL && !(ctx->string_flags & (CFG_INLINE_NAME | CFG_BORROWED_NAME))) {
+        size_t size = strlen(ctx->name) + 1;
+        cfg->mem.names -= size;
+        if (cfg__in_block(cfg, ctx->name)) {
+            cfg->mem.unused += size;
+        } else {
+            cfg__free(cfg, ctx->name, size);
+        }
+    }
+    if (ctx->value != NULL && ctx->string_flags & CFG_SHARED_VALUE) {
+        cfg->intern.refs_size -= strlen(ctx->value) + 1;
+    } else if (ctx->value != NULL && !(ctx->string_flags & (CFG_INLINE_VALUE | CFG_BORROWED_VALUE))) {
+        size_t size = strlen(ctx->value) + 1;
+        cfg->mem.values -= size;
+        if (cfg__in_block(cfg, ctx->value)) {
+            cfg->mem.unused += size;
+        } else {
+            cfg__free(cfg, ctx->value, size);
+        }
+    }
+}
+
+static void cfg__image_measure(const Cfg_Variable *ctx, size_t *nodes, size_t *strings)
+{
+    *nodes += ctx->vars_len;
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        const Cfg_Variable *var = &ctx->vars[i];
+        if (var->name != NULL) *strings += strlen(var->name) + 1;
+        if (var->value != NULL) *strings += strlen(var->value) + 1;
+        cfg__image_measure(var, nodes, strings);
+    }
+}
+
+static uint32_t cfg__image_string(char *strings, uint32_t *offset, const char *str)
+{
+    uint32_t res = *offset;
+    size_t len = strlen(str) + 1;
+    memcpy(strings + res, str, len);
+    *offset += (uint32_t)len;
+    return res;
+}
+
+static uint32_t cfg__image_type_code(Cfg_Type type)
+{
+    uint32_t code = 0;
+    while (type != CFG_TYPE_NONE) {
+        type >>= 1;
+        code++;
+    }
+    return code;
+}
+
+static void cfg__image_copy(Cfg_Image_Node *nodes, uint32_t *hashes, char *strings, uint32_t idx,
+                            const Cfg_Variable *ctx, uint32_t *next_node, uint32_t *next_string)
+{
+    // Inner nodes of a context are placed together, then each of them is filled in
+    uint32_t first = *next_node;
+    *next_node += (uint32_t)ctx->vars_len;
+    nodes[idx].value = first;
+
+    const uint32_t *ctx_hashes = cfg__context_hashes(ctx);
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        const Cfg_Variable *var = &ctx->vars[i];
+        Cfg_Image_Node *node = &nodes[first + i];
+        node->name = var->name != NULL ? cfg__image_string(strings, next_string, var->name) : CFG_IMAGE_NO_NAME;
+        node->info = cfg__image_type_code(var->type) | (uint32_t)var->vars_len << CFG_IMAGE_TYPE_BITS;
+        hashes[first + i] = ctx_hashes[i];
+        if (var->value != NULL) {
+            node->value = cfg__image_string(strings, next_string, var->value);
+        } else {
+            cfg__image_copy(nodes, hashes, strings, first + i, var, next_node, next_string);
+        }
+    }
+}
+
+static void cfg__image_init(Cfg_Image *image, const Cfg_Image_Header *header, size_t size)
+{
+    const Cfg_Image_Node *nodes = (const Cfg_Image_Node *)(header + 1);
+    const uint32_t *hashes = (const uint32_t *)(nodes + header->nodes_len);
+    image->nodes = nodes;
+    image->hashes = hashes;
+    image->strings = (const char *)(hashes + header->nodes_len);
+    image->nodes_len = header->nodes_len;
+    image->strings_size = header->strings_size;
+    image->data = (void *)header;
+    image->size = size;
+}
+
+#ifdef CFG_POSIX_IO
+static bool cfg__image_valid(const Cfg_Image *image)
+{
+    const Cfg_Image_Node *nodes = image->nodes;
+    uint32_t len = image->nodes_len;
+    uint32_t container_codes = 1u << cfg__image_type_code(CFG_TYPE_ARRAY) | 1u << cfg__image_type_code(CFG_TYPE_LIST)
+                             | 1u << cfg__image_type_code(CFG_TYPE_STRUCT);
+    if (image->strings_size > 0 && image->strings[image->strings_size - 1] != '\0') return false;
+    if ((nodes[0].info & ((1u << CFG_IMAGE_TYPE_BITS) - 1)) != cfg__image_type_code(CFG_TYPE_STRUCT)
+        || nodes[0].name != CFG_IMAGE_NO_NAME) {
+        return false;
+    }
+
+    // Inner nodes must come after their context, `seen` marks nodes which already have a context
+    size_t seen_size = ((size_t)len + 7) / 8;
+    unsigned char *seen = cfg__default_alloc(NULL, seen_size);
+    if (!seen) return false;
+    memset(seen, 0, seen_size);
+    uint32_t inner = 0;
+    bool valid = true;
+    for (uint32_t i = 0; i < len && valid; ++i) {
+        uint32_t code = nodes[i].info & ((1u << CFG_IMAGE_TYPE_BITS) - 1);
+        uint32_t count = nodes[i].info >> CFG_IMAGE_TYPE_BITS;
+        if (code == 0 || code > cfg__image_type_code(CFG_TYPE_STRUCT)) {
+            valid = false;
+        } else if (!(container_codes & 1u << code)) {
+            valid = count == 0 && nodes[i].value < image->strings_size;
+        } else if (count > 0) {
+            uint32_t first = nodes[i].value;
+            valid = first > i && first <= len && count <= len - first;
+            bool named = code == cfg__image_type_code(CFG_TYPE_STRUCT);
+            for (uint32_t j = first; valid && j < first + count; ++j) {
+                uint32_t name = nodes[j].name;
+                valid = !(seen[j / 8] & 1u << j % 8)
+                     && (named ? name < image->strings_size : name == CFG_IMAGE_NO_NAME);
+                seen[j / 8] |= (unsigned char)(1u << j % 8);
+            }
+            inner += count;
+        }
+    }
+    cfg__default_free(NULL, seen, seen_size);
+    // Every node except global context is inner node of exactly one context
+    return valid && inner == len - 1;
+}
+
+static int cfg__shared_fd(void)
+{
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+    return memfd_create("cfg_image", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    // Name is only needed until the object is unlinked
+    static unsigned counter;
+    char name[64];
+    snprintf(name, sizeof(name), "/cfg_image_%ld_%u", (long)getpid(), counter++);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) shm_unlink(name);
+    return fd;
+#endif
+}
+#endif
+
+static const Cfg_Image_Node *cfg__node(Cfg_Node node)
+{
+    if (node.image == NULL || node.idx >= node.image->nodes_len) return NULL;
+    return &node.image->nodes[node.idx];
+}
+
+static const char *cfg__node_value(Cfg_Node node, Cfg_Type type)
+{
+    const Cfg_Image_Node *n = cfg__node(node);
+    if (!n || cfg_node_type(node) != type) return NULL;
+    return node.image->strings + n->value;
+}
+
+static void cfg__compact_measure(Cfg_Variable *ctx, size_t *nodes, size_t *count, size_t *strings)
+{
+    *nodes += cfg__vars_size(ctx->vars_len);
+    *count += ctx->vars_len;
+    for (size_t i = 0; i < ctx->vars_len; ++i) {
+        Cfg_Variable *var = &ctx->vars[i];
+        if (var->name != NULL && !(var->string_flags & CFG_INLINE_NAME)) *strings += strlen(var->name) + 1;
+        if (var->value != NULL && !(var->string_flags & (CFG_INLINE_VALUE | CFG_SHARED_VALUE))) {
+            *strings += strlen(var->value) + 1;
+        }
+        cfg__compact_measure(var, nodes, count, strings);
+    }
+}
+
+static void cfg__compact_copy(Cfg_Variable *dst, const Cfg_Variable *src, char **nodes, char **strings)
+{
+    if (src->vars_len == 0) {
+        dst->vars = NULL;
+        dst->vars_len = 0;
+        dst->vars_cap = 0;
+        return;
+    }
+
+    // Whole array of inner variables first, then subtrees of each of them
+    dst->vars = (Cfg_Variable *)*nodes;
+    dst->vars_len = src->vars_len;
+    dst->vars_cap = src->vars_len;
+    *nodes += cfg__vars_size(src->vars_len);
+    memcpy(dst->vars, src->vars, sizeof(Cfg_Variable) * src->vars_len);
+    memcpy(cfg__context_hashes(dst), cfg__context_hashes(src), sizeof(uint32_t) * src->vars_len);
+
+    for (size_t i = 0; i < src->vars_len; ++i) {
+        Cfg_Variable *var = &dst->vars[i];
+        var->prev = dst;
+        cfg__variable_relink_strings(var);
+        if (var->name != NULL && !(var->string_flags & CFG_INLINE_NAME)) {
+            size_t size = strlen(var->name) + 1;
+            memcpy(*strings, var->name, size);
+            var->name = *strings;
+            *strings += size;
+        }
+        // Interned values stay shared and are not copied
+        if (var->value != NULL && !(var->string_flags & (CFG_INLINE_VALUE | CFG_SHARED_VALUE))) {
+            size_t size = strlen(var->value) + 1;
+            memcpy(*strings, var->value, size);
+            var->value = *strings;
+            *strings += size;
+        }
+    }
+
+    for (size_t i = 0; i < src->vars_len; ++i) {
+        cfg__compact_copy(&dst->vars[i], &src->vars[i], nodes, strings);
+    }
+}
+
+static Cfg_Lexer *cfg__buffer_tokenize(Cfg_Config *cfg, char *buffer)
+{
+    Cfg_Lexer *lexer = cfg__lexer_create(cfg);
+    if (!lexer) return NULL;
+    lexer->ch_current = buffer;
+
+    while (*lexer->ch_current != '\0') {
+        if (*lexer->ch_current == '\n') {
+            lexer->comment_eol = false;
+            lexer->line++;
+            lexer->column = 1;
+            lexer->ch_current++;
+            continue;
+        }
+
+        if (*lexer->ch_current == '/') {
+            lexer->ch_current++;
+            lexer->column++;
+            if (*lexer->ch_current == '/') {
+                lexer->comment_eol = true;
+                lexer->ch_current++;
+                lexer->column++;
+                continue;
+            } else if (*lexer->ch_current == '*') {
+                lexer->comment = true;
+                lexer->ch_current++;
+                lexer->column++;
+                continue;
+            }
+        }
+
+        if (*lexer->ch_current == '*' && lexer->comment) {
+            lexer->ch_current++;
+            lexer->column++;
+            if (*lexer->ch_current == '/') {
+                lexer->comment = false;
+                lexer->ch_current++;
+                lexer->column++;
+                continue;
+            }
+        }
+
+        if (lexer->comment || lexer->comment_eol) {
+            lexer->ch_current++;
             lexer->column++;
             continue;
         }
@@ -599,31 +2556,31 @@ static Cfg_Lexer *cfg__buffer_tokenize(Cfg_Config *cfg, char *buffer)
         case ' ':
             break;
         case '=':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_EQ, "=");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_EQ, "=", 0);
             break;
         case ';':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_SEMICOLON, ";");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_SEMICOLON, ";", 0);
             break;
         case ',':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_COMMA, ",");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_COMMA, ",", 0);
             break;
         case '[':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_BRACKET, "[");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_BRACKET, "[", 0);
             break;
         case ']':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_BRACKET, "]");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_BRACKET, "]", 0);
             break;
         case '(':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_PARENTHESIS, "(");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_PARENTHESIS, "(", 0);
             break;
         case ')':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_PARENTHESIS, ")");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_PARENTHESIS, ")", 0);
             break;
         case '{':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_CURLY_BRACKET, "{");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_CURLY_BRACKET, "{", 0);
             break;
         case '}':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_CURLY_BRACKET, "}");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_CURLY_BRACKET, "}", 0);
             break;
         default:
             if (isdigit(*lexer->ch_current)) {
@@ -643,35 +2600,39 @@ static Cfg_Lexer *cfg__buffer_tokenize(Cfg_Config *cfg, char *buffer)
                 if (dots > 1) {
                     cfg->err.type = CFG_ERROR_UNKNOWN_TOKEN;
                     snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Unknown token at line:%lu, column:%lu", lexer->line, lexer->column);
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
 
                 size_t len = lexer->ch_current - lexer->str_start;
-                char *value = malloc(sizeof(char) * (len + 1));
+                char *value = cfg__alloc(cfg, sizeof(char) * (len + 1));
                 if (!value) {
                     cfg->err.type = CFG_ERROR_NO_MEMORY;
                     sprintf(cfg->err.message, "Failed to allocate memory");
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
                 value[len] = '\0';
                 strncpy(value, lexer->str_start, len);
 
                 if (dots < 1) {
-                    cfg__lexer_add_token(lexer, CFG_TOKEN_INT, value);
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_INT, value, len + 1);
                 } else {
-                    cfg__lexer_add_token(lexer, CFG_TOKEN_DOUBLE, value);
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_DOUBLE, value, len + 1);
                 }
 
                 continue;
             } else if (*lexer->ch_current == '"') {
                 lexer->str_start = ++lexer->ch_current;
-                char *value = cfg__lexer_parse_string_buffer(lexer);
+                size_t size = 0;
+                char *value = cfg__lexer_parse_string_buffer(lexer, &size);
                 if (!value) {
                     cfg->err.type = CFG_ERROR_NO_MEMORY;
                     sprintf(cfg->err.message, "Failed to allocate memory");
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
-                cfg__lexer_add_token(lexer, CFG_TOKEN_STRING, value);
+                cfg__lexer_add_token(lexer, CFG_TOKEN_STRING, value, size);
                 continue;
             } else {
                 lexer->str_start = lexer->ch_current;
@@ -699,38 +2660,46 @@ static Cfg_Lexer *cfg__buffer_tokenize(Cfg_Config *cfg, char *buffer)
                 }
 
                 size_t len = lexer->ch_current - lexer->str_start;
-                char *value = malloc(sizeof(char) * (len + 1));
+                char *value = cfg__alloc(cfg, sizeof(char) * (len + 1));
                 if (!value) {
                     cfg->err.type = CFG_ERROR_NO_MEMORY;
                     sprintf(cfg->err.message, "Failed to allocate memory");
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
                 value[len] = '\0';
                 strncpy(value, lexer->str_start, len);
 
+                // Delimiter which ended the word is the next token (`name=value`)
                 if (strcmp(value, "true") == 0 ||
                     strcmp(value, "false") == 0) {
-                    cfg__lexer_add_token(lexer, CFG_TOKEN_BOOL, value);
-                    continue;
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_BOOL, value, len + 1);
+                } else if (strcmp(value, "@include") == 0) {
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_INCLUDE, value, len + 1);
                 } else {
-                    cfg__lexer_add_token(lexer, CFG_TOKEN_IDENTIFIER, value);
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_IDENTIFIER, value, len + 1);
                 }
+                continue;
             }
         }
         lexer->ch_current++;
         lexer->column++;
     }
 
-    cfg__lexer_add_token(lexer, CFG_TOKEN_EOF, "\0");
+    cfg__lexer_add_token(lexer, CFG_TOKEN_EOF, "\0", 0);
+#ifdef CFG_STATS
+    lexer->bytes = lexer->ch_current - buffer;
+#endif
     return lexer;
 }
 
 static Cfg_Lexer *cfg__stream_tokenize(Cfg_Config *cfg, FILE *stream)
 {
     Cfg_Lexer *lexer = cfg__lexer_create(cfg);
+    if (!lexer) return NULL;
     char c;
 
-    while ((c = fgetc(stream)) != EOF) {
+    while ((c = cfg__lexer_getc(lexer, stream)) != EOF) {
         if (c == '\n') {
             lexer->comment_eol = false;
             lexer->line++;
@@ -739,7 +2708,7 @@ static Cfg_Lexer *cfg__stream_tokenize(Cfg_Config *cfg, FILE *stream)
         }
 
         if (c == '/') {
-            c = fgetc(stream);
+            c = cfg__lexer_getc(lexer, stream);
             lexer->column++;
             if (c == '/') {
                 lexer->comment_eol = true;
@@ -754,7 +2723,7 @@ static Cfg_Lexer *cfg__stream_tokenize(Cfg_Config *cfg, FILE *stream)
 
         if (c == '*' && lexer->comment) {
             lexer->column++;
-            if ((c = fgetc(stream)) == '/') {
+            if ((c = cfg__lexer_getc(lexer, stream)) == '/') {
                 lexer->comment = false;
                 lexer->column++;
                 continue;
@@ -770,40 +2739,41 @@ static Cfg_Lexer *cfg__stream_tokenize(Cfg_Config *cfg, FILE *stream)
         case ' ':
             break;
         case '=':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_EQ, "=");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_EQ, "=", 0);
             break;
         case ';':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_SEMICOLON, ";");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_SEMICOLON, ";", 0);
             break;
         case ',':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_COMMA, ",");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_COMMA, ",", 0);
             break;
         case '[':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_BRACKET, "[");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_BRACKET, "[", 0);
             break;
         case ']':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_BRACKET, "]");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_BRACKET, "]", 0);
             break;
         case '(':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_PARENTHESIS, "(");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_PARENTHESIS, "(", 0);
             break;
         case ')':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_PARENTHESIS, ")");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_PARENTHESIS, ")", 0);
             break;
         case '{':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_CURLY_BRACKET, "{");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_LEFT_CURLY_BRACKET, "{", 0);
             break;
         case '}':
-            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_CURLY_BRACKET, "}");
+            cfg__lexer_add_token(lexer, CFG_TOKEN_RIGHT_CURLY_BRACKET, "}", 0);
             break;
         default:
             if (isdigit(c)) {
                 size_t len = 0;
                 size_t cap = INIT_STRING_SIZE;
-                char *value = malloc(sizeof(char) * cap);
+                char *value = cfg__alloc(cfg, sizeof(char) * cap);
                 if (!value) {
                     cfg->err.type = CFG_ERROR_NO_MEMORY;
                     sprintf(cfg->err.message, "Failed to allocate memory");
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
                 size_t dots = 0;
@@ -815,68 +2785,75 @@ static Cfg_Lexer *cfg__stream_tokenize(Cfg_Config *cfg, FILE *stream)
 
                     if (len == cap) {
                         cap *= 2;
-                        value = realloc(value, sizeof(char) * cap);
+                        value = cfg__realloc(cfg, value, sizeof(char) * cap / 2, sizeof(char) * cap);
                         if (!value) {
                             cfg->err.type = CFG_ERROR_NO_MEMORY;
                             sprintf(cfg->err.message, "Failed to allocate memory");
+                            cfg__lexer_free(lexer);
                             return NULL;
                         }
                     }
                     value[len++] = c;
 
-                    c = fgetc(stream);
+                    c = cfg__lexer_getc(lexer, stream);
                     lexer->column++;
                 }
 
                 if (c == '\0') {
-                    free(value);
+                    cfg__free(cfg, value, sizeof(char) * cap);
                     cfg->err.type = CFG_ERROR_UNEXPECTED_TOKEN;
                     snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Unexpected token at line:%lu, column:%lu", lexer->line, lexer->column);
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
 
                 if (dots > 1) {
-                    free(value);
+                    cfg__free(cfg, value, sizeof(char) * cap);
                     cfg->err.type = CFG_ERROR_UNKNOWN_TOKEN;
                     snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Unknown token at line:%lu, column:%lu", lexer->line, lexer->column);
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
 
                 if (len == cap) {
                     cap++;
-                    value = realloc(value, sizeof(char) * cap);
+                    value = cfg__realloc(cfg, value, sizeof(char) * (cap - 1), sizeof(char) * cap);
                     if (!value) {
                         cfg->err.type = CFG_ERROR_NO_MEMORY;
                         sprintf(cfg->err.message, "Failed to allocate memory");
+                        cfg__lexer_free(lexer);
                         return NULL;
                     }
                 }
                 value[len] = '\0';
 
                 if (dots < 1) {
-                    cfg__lexer_add_token(lexer, CFG_TOKEN_INT, value);
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_INT, value, cap);
                 } else {
-                    cfg__lexer_add_token(lexer, CFG_TOKEN_DOUBLE, value);
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_DOUBLE, value, cap);
                 }
-                ungetc(c, stream);
+                cfg__lexer_ungetc(lexer, c, stream);
                 continue;
             } else if (c == '"') {
-                char *value = cfg__lexer_parse_string_stream(lexer, stream);
+                size_t size = 0;
+                char *value = cfg__lexer_parse_string_stream(lexer, stream, &size);
                 if (!value) {
                     cfg->err.type = CFG_ERROR_NO_MEMORY;
                     sprintf(cfg->err.message, "Failed to allocate memory");
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
-                cfg__lexer_add_token(lexer, CFG_TOKEN_STRING, value);
+                cfg__lexer_add_token(lexer, CFG_TOKEN_STRING, value, size);
                 lexer->column++;
                 continue;
             } else {
                 size_t len = 0;
                 size_t cap = INIT_STRING_SIZE;
-                char *value = malloc(sizeof(char) * cap);
+                char *value = cfg__alloc(cfg, sizeof(char) * cap);
                 if (!value) {
                     cfg->err.type = CFG_ERROR_NO_MEMORY;
                     sprintf(cfg->err.message, "Failed to allocate memory");
+                    cfg__lexer_free(lexer);
                     return NULL;
                 }
                 while (c != ' ' &&
@@ -893,30 +2870,33 @@ static Cfg_Lexer *cfg__stream_tokenize(Cfg_Config *cfg, FILE *stream)
                        c != '}') {
                     if (len == cap) {
                         cap *= 2;
-                        value = realloc(value, sizeof(char) * cap);
+                        value = cfg__realloc(cfg, value, sizeof(char) * cap / 2, sizeof(char) * cap);
                         if (!value) {
                             cfg->err.type = CFG_ERROR_NO_MEMORY;
                             sprintf(cfg->err.message, "Failed to allocate memory");
+                            cfg__lexer_free(lexer);
                             return NULL;
                         }
                     }
                     value[len++] = c;
 
-                    c = fgetc(stream);
+                    c = cfg__lexer_getc(lexer, stream);
                     lexer->column++;
                 }
 
                 if (len == 0) {
+                    cfg__free(cfg, value, sizeof(char) * cap);
                     lexer->column++;
                     continue;
                 }
 
                 if (len == cap) {
                     cap++;
-                    value = realloc(value, sizeof(char) * cap);
+                    value = cfg__realloc(cfg, value, sizeof(char) * (cap - 1), sizeof(char) * cap);
                     if (!value) {
                         cfg->err.type = CFG_ERROR_NO_MEMORY;
                         sprintf(cfg->err.message, "Failed to allocate memory");
+                        cfg__lexer_free(lexer);
                         return NULL;
                     }
                 }
@@ -924,32 +2904,48 @@ static Cfg_Lexer *cfg__stream_tokenize(Cfg_Config *cfg, FILE *stream)
 
                 if (strcmp(value, "true") == 0 ||
                     strcmp(value, "false") == 0) {
-                    cfg__lexer_add_token(lexer, CFG_TOKEN_BOOL, value);
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_BOOL, value, cap);
+                } else if (strcmp(value, "@include") == 0) {
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_INCLUDE, value, cap);
                 } else {
-                    cfg__lexer_add_token(lexer, CFG_TOKEN_IDENTIFIER, value);
+                    cfg__lexer_add_token(lexer, CFG_TOKEN_IDENTIFIER, value, cap);
                 }
-                ungetc(c, stream);
+                cfg__lexer_ungetc(lexer, c, stream);
                 continue;
             }
         }
         lexer->column++;
     }
 
-    cfg__lexer_add_token(lexer, CFG_TOKEN_EOF, "\0");
+    cfg__lexer_add_token(lexer, CFG_TOKEN_EOF, "\0", 0);
 
     return lexer;
 }
 
 static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
+{
+    cfg__err_clear(cfg);
+    if (cfg__frozen(cfg)) return 1;
+    cfg->generation++;
+    Cfg_Include_Frame frame;
+    bool pushed = cfg__include_begin(cfg, lexer, &frame);
+    int res = cfg__parse_statements(cfg, lexer);
+    if (pushed) cfg__include_end(&frame);
+    return res;
+}
+
+static int cfg__parse_statements(Cfg_Config *cfg, Cfg_Lexer *lexer)
 {
     int prev_token = 0;
-    int expected_token = CFG_TOKEN_IDENTIFIER | CFG_TOKEN_EOF;
+    int expected_token = CFG_TOKEN_IDENTIFIER | CFG_TOKEN_INCLUDE | CFG_TOKEN_EOF;
     Cfg_Type type = CFG_TYPE_NONE;
     char *name = NULL;
     char *value = NULL;
     char *tmp_string_buf = NULL;
+    size_t tmp_string_size = 0;
     Cfg_Token *tokens = lexer->tokens;
     Cfg_Variable *ctx = &cfg->global;
+    const Cfg_Token *include = NULL;
     for (size_t i = lexer->cur_token; i < lexer->tokens_len; ++i) {
         if (cfg->err.type == CFG_ERROR_NO_MEMORY) {
             return 1;
@@ -970,16 +2966,23 @@ static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
                 if (name != NULL && value != NULL) {
                     cfg__context_add_variable(cfg, lexer, ctx, type, name, value);
                     if (type == CFG_TYPE_STRING && tmp_string_buf != NULL) {
-                        free(tmp_string_buf);
+                        cfg__free(cfg, tmp_string_buf, tmp_string_size);
                         tmp_string_buf = NULL;
                     };
                     if (cfg->err.type != CFG_ERROR_NONE) {
                         return 1;
                     }
                 }
+                if (include != NULL) {
+                    cfg__include(cfg, ctx, include);
+                    include = NULL;
+                    if (cfg->err.type != CFG_ERROR_NONE) {
+                        return 1;
+                    }
+                }
                 name = NULL;
                 value = NULL;
-                expected_token = CFG_TOKEN_IDENTIFIER | CFG_TOKEN_EOF;
+                expected_token = CFG_TOKEN_IDENTIFIER | CFG_TOKEN_INCLUDE | CFG_TOKEN_EOF;
                 if (cfg__stack_last_char(lexer) == '{') {
                     expected_token |= CFG_TOKEN_RIGHT_CURLY_BRACKET;
                 }
@@ -996,7 +2999,7 @@ static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
                 }
                 
                 if (type == CFG_TYPE_STRING && tmp_string_buf != NULL) {
-                    free(tmp_string_buf);
+                    cfg__free(cfg, tmp_string_buf, tmp_string_size);
                     tmp_string_buf = NULL;
                 };
                 if (cfg->err.type != CFG_ERROR_NONE) {
@@ -1051,7 +3054,7 @@ static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
                     };
                     cfg__context_add_variable(cfg, lexer, ctx, type, name, value);
                     if (type == CFG_TYPE_STRING && tmp_string_buf != NULL) {
-                        free(tmp_string_buf);
+                        cfg__free(cfg, tmp_string_buf, tmp_string_size);
                         tmp_string_buf = NULL;
                     };
                     if (cfg->err.type != CFG_ERROR_NONE) {
@@ -1097,7 +3100,7 @@ static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
                 if (value != NULL) {
                     cfg__context_add_variable(cfg, lexer, ctx, type, name, value);
                     if (type == CFG_TYPE_STRING && tmp_string_buf != NULL) {
-                        free(tmp_string_buf);
+                        cfg__free(cfg, tmp_string_buf, tmp_string_size);
                         tmp_string_buf = NULL;
                     };
                     if (cfg->err.type != CFG_ERROR_NONE) {
@@ -1131,7 +3134,7 @@ static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
                 }
                 name = NULL;
                 ctx = &ctx->vars[ctx->vars_len - 1];
-                expected_token = CFG_TOKEN_IDENTIFIER | CFG_TOKEN_RIGHT_CURLY_BRACKET;
+                expected_token = CFG_TOKEN_IDENTIFIER | CFG_TOKEN_INCLUDE | CFG_TOKEN_RIGHT_CURLY_BRACKET;
                 break;
             case CFG_TOKEN_RIGHT_CURLY_BRACKET:
                 cfg__stack_pop_char(lexer);
@@ -1155,6 +3158,10 @@ static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
                 name = tokens[i].value;
                 expected_token = CFG_TOKEN_EQ;
                 break;
+            case CFG_TOKEN_INCLUDE:
+                include = &tokens[i];
+                expected_token = CFG_TOKEN_STRING;
+                break;
             case CFG_TOKEN_INT:
                 type = CFG_TYPE_INT;
                 value = tokens[i].value;
@@ -1201,27 +3208,33 @@ static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
                 }
                 break;
             case CFG_TOKEN_STRING:
+                if (include != NULL) {
+                    expected_token = CFG_TOKEN_SEMICOLON;
+                    break;
+                }
                 type = CFG_TYPE_STRING;
                 if (prev_token & CFG_TOKEN_STRING) {
                     if (!tmp_string_buf) {
                         size_t new_size = sizeof(char) * (strlen(value) + strlen(tokens[i].value) + 1);
-                        tmp_string_buf = malloc(new_size);
+                        tmp_string_buf = cfg__alloc(cfg, new_size);
                         if (!tmp_string_buf) {
                             cfg->err.type = CFG_ERROR_NO_MEMORY;
                             sprintf(cfg->err.message, "Failed to allocate memory");
                             return 1;
                         }
+                        tmp_string_size = new_size;
                         strncpy(tmp_string_buf, value, new_size);
                         strncat(tmp_string_buf, tokens[i].value, new_size);
                         value = tmp_string_buf;
                     } else {
                         size_t new_size = sizeof(char) * (strlen(value) + strlen(tokens[i].value) + 1);
-                        tmp_string_buf = realloc(tmp_string_buf, new_size);
+                        tmp_string_buf = cfg__realloc(cfg, tmp_string_buf, tmp_string_size, new_size);
                         if (!tmp_string_buf) {
                             cfg->err.type = CFG_ERROR_NO_MEMORY;
                             sprintf(cfg->err.message, "Failed to allocate memory");
                             return 1;
                         }
+                        tmp_string_size = new_size;
                         strncat(tmp_string_buf, tokens[i].value, new_size);
                         value = tmp_string_buf;
                     }
@@ -1255,45 +3268,927 @@ static int cfg__parse_tokens(Cfg_Config *cfg, Cfg_Lexer *lexer)
     return 0;
 }
 
+#ifdef CFG_POSIX_IO
+static Cfg_Error_Type cfg__file_load_fd(Cfg_Config *cfg, int fd, const char *path, char *buf, size_t len, size_t cap)
+{
+    Cfg_Error_Type err = CFG_ERROR_NONE;
+    while (true) {
+        if (len > FILE_MAX_SIZE) {
+            err = CFG_ERROR_FILE_TOO_LARGE;
+            snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "File `%s` seems to be really large", path);
+            break;
+        }
+        // Keep one byte for terminating zero
+        if (cap - len <= 1) {
+            size_t new_cap = cap ? cap * 2 : FILE_READ_CHUNK;
+            char *new_buf = cfg__realloc(cfg, buf, cap, new_cap);
+            if (!new_buf) {
+                err = CFG_ERROR_NO_MEMORY;
+                sprintf(cfg->err.message, "Failed to allocate memory");
+                break;
+            }
+            buf = new_buf;
+            cap = new_cap;
+        }
+
+        ssize_t res = pread(fd, buf + len, cap - len - 1, (off_t)len);
+        if (res < 0 && errno == EINTR) continue;
+        if (res < 0) {
+            err = CFG_ERROR_OPEN_FILE;
+            snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Failed to read file `%s`", path);
+            break;
+        }
+        if (res == 0) break;
+        len += (size_t)res;
+    }
+
+    if (err == CFG_ERROR_NONE) {
+        buf[len] = '\0';
+        err = cfg_load_buffer(cfg, buf);
+    } else {
+        cfg->err.type = err;
+    }
+    cfg__free(cfg, buf, cap);
+    return err;
+}
+#endif
+
+static char *cfg__include_path(const char *file, const char *path)
+{
+    char joined[INCLUDE_PATH_MAX];
+    size_t dir_len = 0;
+    if (file != NULL && path[0] != '/') {
+        const char *slash = strrchr(file, '/');
+        if (slash != NULL) dir_len = (size_t)(slash - file) + 1;
+    }
+    size_t len = strlen(path);
+    if (dir_len + len + 1 > sizeof(joined)) return NULL;
+    if (dir_len > 0) memcpy(joined, file, dir_len);
+    memcpy(joined + dir_len, path, len + 1);
+
+#if defined(CFG_REALPATH)
+    char resolved[INCLUDE_PATH_MAX];
+    if (!realpath(joined, resolved)) return NULL;
+    len = strlen(resolved);
+#elif defined(CFG_POSIX_IO)
+    struct stat st;
+    if (stat(joined, &st) != 0) return NULL;
+    char *resolved = joined;
+    len += dir_len;
+#else
+    char *resolved = joined;
+    len += dir_len;
+#endif
+    char *res = CFG_MALLOC(len + 1);
+    if (res != NULL) memcpy(res, resolved, len + 1);
+    return res;
+}
+
+static bool cfg__include_stat(const char *path, Cfg_Include_Stamp *stamp)
+{
+#ifdef CFG_POSIX_IO
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+    stamp->mtime_sec = (long long)st.st_mtime;
+    stamp->mtime_nsec = (long long)CFG_MTIME_NSEC(st);
+    stamp->size = (long long)st.st_size;
+    stamp->ino = (unsigned long long)st.st_ino;
+    stamp->dev = (unsigned long long)st.st_dev;
+    return true;
+#else
+    (void)path;
+    (void)stamp;
+    return false;
+#endif
+}
+
+static bool cfg__include_stamp_equal(const Cfg_Include_Stamp *a, const Cfg_Include_Stamp *b)
+{
+    return a->mtime_sec == b->mtime_sec && a->mtime_nsec == b->mtime_nsec && a->size == b->size
+        && a->ino == b->ino && a->dev == b->dev;
+}
+
+static void cfg__include_lock(void)
+{
+    while (cfg__atomic_exchange(&cfg__includes.lock, 1, CFG_ACQUIRE)) {}
+}
+
+static void cfg__include_unlock(void)
+{
+    cfg__atomic_store(&cfg__includes.lock, 0, CFG_RELEASE);
+}
+
+static size_t cfg__include_find(const char *path, uint32_t hash)
+{
+    size_t i = 0;
+    for (; i < cfg__includes.len; ++i) {
+        Cfg_Include *entry = cfg__includes.entries[i];
+        if (entry->hash == hash && strcmp(entry->path, path) == 0) break;
+    }
+    return i;
+}
+
+static Cfg_Include *cfg__include_drop(size_t idx)
+{
+    Cfg_Include *entry = cfg__includes.entries[idx];
+    cfg__includes.entries[idx] = cfg__includes.entries[--cfg__includes.len];
+    if (entry->refs == 0) return entry;
+    entry->stale = true;
+    return NULL;
+}
+
+static void cfg__include_free(Cfg_Include *entry)
+{
+    cfg_config_deinit(entry->cfg);
+    CFG_FREE(entry->path);
+    CFG_FREE(entry);
+}
+
+static Cfg_Include *cfg__include_acquire(const char *path, const Cfg_Include_Stamp *stamp)
+{
+    uint32_t hash = cfg__hash(path, strlen(path));
+    Cfg_Include *entry = NULL;
+    Cfg_Include *dropped = NULL;
+    cfg__include_lock();
+    size_t i = cfg__include_find(path, hash);
+    if (i < cfg__includes.len) {
+        if (cfg__include_stamp_equal(&cfg__includes.entries[i]->stamp, stamp)) {
+            entry = cfg__includes.entries[i];
+            entry->refs++;
+        } else {
+            dropped = cfg__include_drop(i);
+        }
+    }
+    cfg__include_unlock();
+    if (dropped) cfg__include_free(dropped);
+
+    // Files included by cached file are checked without lock, entry is referenced
+    if (entry != NULL && !cfg__include_valid(entry->cfg)) {
+        cfg__include_lock();
+        i = cfg__include_find(path, hash);
+        // Entry is referenced here, so it is only marked stale and freed by release
+        if (i < cfg__includes.len && cfg__includes.entries[i] == entry) cfg__include_drop(i);
+        cfg__include_unlock();
+        cfg__include_release(entry);
+        entry = NULL;
+    }
+    return entry;
+}
+
+static Cfg_Include *cfg__include_store(char *path, const Cfg_Include_Stamp *stamp, Cfg_Config *inc)
+{
+    Cfg_Include *entry = CFG_MALLOC(sizeof(Cfg_Include));
+    if (!entry) return NULL;
+    entry->path = path;
+    entry->hash = cfg__hash(path, strlen(path));
+    entry->stamp = *stamp;
+    entry->cfg = inc;
+    entry->refs = 1;
+    entry->stale = false;
+
+    Cfg_Include *dropped = NULL;
+    cfg__include_lock();
+    size_t i = cfg__include_find(path, entry->hash);
+    if (i < cfg__includes.len) {
+        // Another thread parsed the same file first
+        Cfg_Include *cur = cfg__includes.entries[i];
+        if (cfg__include_stamp_equal(&cur->stamp, stamp)) {
+            cur->refs++;
+            cfg__include_unlock();
+            cfg__include_free(entry);
+            return cur;
+        }
+        dropped = cfg__include_drop(i);
+    }
+    if (cfg__includes.len == cfg__includes.cap) {
+        size_t cap = cfg__includes.cap ? cfg__includes.cap * 2 : INIT_INCLUDE_ENTRIES;
+        Cfg_Include **entries = CFG_REALLOC(cfg__includes.entries, sizeof(Cfg_Include *) * cap);
+        if (!entries) {
+            cfg__include_unlock();
+            if (dropped) cfg__include_free(dropped);
+            CFG_FREE(entry);
+            return NULL;
+        }
+        cfg__includes.entries = entries;
+        cfg__includes.cap = cap;
+    }
+    cfg__includes.entries[cfg__includes.len++] = entry;
+    cfg__include_unlock();
+    if (dropped) cfg__include_free(dropped);
+    return entry;
+}
+
+static void cfg__include_release(Cfg_Include *entry)
+{
+    cfg__include_lock();
+    bool unused = --entry->refs == 0 && entry->stale;
+    cfg__include_unlock();
+    if (unused) cfg__include_free(entry);
+}
+
+static bool cfg__include_valid(const Cfg_Config *inc)
+{
+    for (size_t i = 0; i < inc->includes_len; ++i) {
+        Cfg_Include_Stamp stamp;
+        if (!cfg__include_stat(inc->includes[i].path, &stamp)
+            || !cfg__include_stamp_equal(&stamp, &inc->includes[i].stamp)) return false;
+    }
+    return true;
+}
+
+static bool cfg__include_depend(Cfg_Config *cfg, const char *path, const Cfg_Include_Stamp *stamp)
+{
+    for (size_t i = 0; i < cfg->includes_len; ++i) {
+        if (strcmp(cfg->includes[i].path, path) == 0) return true;
+    }
+    size_t len = cfg->includes_len;
+    size_t size = strlen(path) + 1;
+    char *dup = cfg__strdup(cfg, path);
+    if (!dup) return false;
+    Cfg_Include_Dep *includes = cfg__realloc(cfg, cfg->includes, sizeof(Cfg_Include_Dep) * len, sizeof(Cfg_Include_Dep) * (len + 1));
+    if (!includes) {
+        cfg__free(cfg, dup, size);
+        return false;
+    }
+    includes[len].path = dup;
+    includes[len].stamp = *stamp;
+    cfg->includes = includes;
+    cfg->includes_len++;
+    cfg->mem.includes += sizeof(Cfg_Include_Dep) + size;
+    return true;
+}
+
+static bool cfg__include_active(const char *path)
+{
+    for (Cfg_Include_Frame *frame = cfg__include_stack; frame != NULL; frame = frame->prev) {
+        if (strcmp(frame->path, path) == 0) return true;
+    }
+    return false;
+}
+
+static bool cfg__include_begin(Cfg_Config *cfg, Cfg_Lexer *lexer, Cfg_Include_Frame *frame)
+{
+    Cfg_Token *tokens = lexer->tokens;
+    size_t includes = 0;
+    for (size_t i = lexer->cur_token; i + 1 < lexer->tokens_len; ++i) {
+        if (tokens[i].type == CFG_TOKEN_INCLUDE && tokens[i + 1].type == CFG_TOKEN_STRING) includes++;
+    }
+    if (includes == 0) return false;
+
+    frame->path = cfg->file != NULL ? cfg__include_path(NULL, cfg->file) : NULL;
+    if (frame->path != NULL) {
+        frame->prev = cfg__include_stack;
+        cfg__include_stack = frame;
+    }
+
+    // Included files which are not cached are loaded in one batch, includes are
+    // copied in order by parser and find them in cache. Failed files are loaded again
+    // by parser to report their errors
+    char **paths = CFG_MALLOC(sizeof(char *) * includes);
+    Cfg_Config **cfgs = CFG_MALLOC(sizeof(Cfg_Config *) * includes);
+    Cfg_Include_Stamp *stamps = CFG_MALLOC(sizeof(Cfg_Include_Stamp) * includes);
+    size_t count = 0;
+    if (!paths || !cfgs || !stamps) includes = 0;
+    for (size_t i = lexer->cur_token; includes > 0 && i + 1 < lexer->tokens_len; ++i) {
+        if (tokens[i].type != CFG_TOKEN_INCLUDE || tokens[i + 1].type != CFG_TOKEN_STRING) continue;
+        char *path = cfg__include_path(cfg->file, tokens[i + 1].value);
+        if (!path) continue;
+        bool skip = !cfg__include_stat(path, &stamps[count]) || cfg__include_active(path);
+        for (size_t j = 0; j < count && !skip; ++j) {
+            skip = strcmp(paths[j], path) == 0;
+        }
+        if (!skip) {
+            Cfg_Include *entry = cfg__include_acquire(path, &stamps[count]);
+            if (entry != NULL) {
+                cfg__include_release(entry);
+                skip = true;
+            }
+        }
+        if (!skip) {
+            cfgs[count] = cfg_config_init();
+            skip = cfgs[count] == NULL;
+        }
+        if (skip) {
+            CFG_FREE(path);
+            continue;
+        }
+        paths[count++] = path;
+    }
+
+    if (count > 0) cfg_load_files(cfgs, (const char *const *)paths, count);
+    for (size_t i = 0; i < count; ++i) {
+        Cfg_Include *entry = NULL;
+        if (cfgs[i]->err.type == CFG_ERROR_NONE) entry = cfg__include_store(paths[i], &stamps[i], cfgs[i]);
+        if (entry != NULL) {
+            cfg__include_release(entry);
+        } else {
+            cfg_config_deinit(cfgs[i]);
+            CFG_FREE(paths[i]);
+        }
+    }
+    CFG_FREE(paths);
+    CFG_FREE(cfgs);
+    CFG_FREE(stamps);
+    return frame->path != NULL;
+}
+
+static void cfg__include_end(Cfg_Include_Frame *frame)
+{
+    cfg__include_stack = frame->prev;
+    CFG_FREE(frame->path);
+}
+
+static void cfg__include(Cfg_Config *cfg, Cfg_Variable *ctx, const Cfg_Token *token)
+{
+    const char *name = token[1].value;
+    char *path = cfg__include_path(cfg->file, name);
+    if (!path) {
+        cfg->err.type = CFG_ERROR_INCLUDE;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Failed to open included file `%s` at line:%lu, column:%lu",
+                 name, token->line, token->column);
+        return;
+    }
+
+    Cfg_Include_Stamp stamp;
+    bool cached = cfg__include_stat(path, &stamp);
+    Cfg_Include *entry = cached ? cfg__include_acquire(path, &stamp) : NULL;
+    Cfg_Config *inc = entry != NULL ? entry->cfg : NULL;
+    if (!inc) {
+        if (cfg__include_active(path)) {
+            cfg->err.type = CFG_ERROR_INCLUDE;
+            snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Include cycle: `%s` includes itself at line:%lu, column:%lu",
+                     name, token->line, token->column);
+            CFG_FREE(path);
+            return;
+        }
+        inc = cfg_config_init();
+        if (!inc) {
+            cfg->err.type = CFG_ERROR_NO_MEMORY;
+            sprintf(cfg->err.message, "Failed to allocate memory");
+            CFG_FREE(path);
+            return;
+        }
+        if (cfg_load_file(inc, path) != CFG_ERROR_NONE) {
+            char message[ERROR_MESSAGE_LEN];
+            memcpy(message, inc->err.message, ERROR_MESSAGE_LEN);
+            cfg->err.type = CFG_ERROR_INCLUDE;
+            snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Failed to include `%.128s` at line:%lu, column:%lu: %.256s",
+                     name, token->line, token->column, message);
+            cfg_config_deinit(inc);
+            CFG_FREE(path);
+            return;
+        }
+        if (cached) entry = cfg__include_store(path, &stamp, inc);
+        if (entry != NULL) {
+            inc = entry->cfg;
+            path = NULL;
+        }
+    }
+
+    // Config depends on included file and on files it includes
+    bool recorded = !cached || cfg__include_depend(cfg, entry != NULL ? entry->path : path, &stamp);
+    for (size_t i = 0; i < inc->includes_len && recorded; ++i) {
+        recorded = cfg__include_depend(cfg, inc->includes[i].path, &inc->includes[i].stamp);
+    }
+    if (!recorded) {
+        cfg->err.type = CFG_ERROR_NO_MEMORY;
+        sprintf(cfg->err.message, "Failed to allocate memory");
+    }
+    // Names of included file are unique, so they are checked only against variables defined
+    // before include (none if it is the first statement) and nothing is copied on redefinition
+    for (size_t i = 0; i < inc->global.vars_len && ctx->vars_len > 0 && recorded; ++i) {
+        const char *var_name = inc->global.vars[i].name;
+        if (cfg__context_find_variable(ctx, var_name) >= 0) {
+            cfg->err.type = CFG_ERROR_VARIABLE_REDEFINITION;
+            snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Variable `%s` included from `%s` at line:%lu, column:%lu is already defined",
+                     var_name, name, token->line, token->column);
+            recorded = false;
+        }
+    }
+    if (recorded) cfg__context_copy(cfg, ctx, &inc->global);
+    if (entry != NULL) {
+        cfg__include_release(entry);
+    } else {
+        cfg_config_deinit(inc);
+    }
+    CFG_FREE(path);
+}
+
+static bool cfg__context_copy(Cfg_Config *cfg, Cfg_Variable *dst, const Cfg_Variable *src)
+{
+    for (size_t i = 0; i < src->vars_len; ++i) {
+        const Cfg_Variable *var = &src->vars[i];
+        // Included contexts are copied at exact size like arrays of clones
+        Cfg_Variable *copy = cfg__context_append(cfg, dst, var->type, var->name, var->value, var->vars_len);
+        if (!copy || (var->vars != NULL && !cfg__context_copy(cfg, copy, var))) return false;
+    }
+    return true;
+}
+
+#ifdef CFG_IO_URING
+static bool cfg__ring_init(Cfg_Ring *ring, unsigned entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(Cfg_Ring));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) return false;
+
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        if (ring->cq_size > ring->sq_size) ring->sq_size = ring->cq_size;
+        ring->cq_size = ring->sq_size;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_ptr = single_mmap ? ring->sq_ptr
+                               : mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    ring->entries = params.sq_entries;
+    if (ring->sq_ptr == MAP_FAILED || ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        cfg__ring_free(ring);
+        return false;
+    }
+
+    char *sq = ring->sq_ptr;
+    char *cq = ring->cq_ptr;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return true;
+}
+
+static void cfg__ring_free(Cfg_Ring *ring)
+{
+    if (ring->sqes && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->entries * sizeof(struct io_uring_sqe));
+    if (ring->cq_ptr && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr) munmap(ring->cq_ptr, ring->cq_size);
+    if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED) munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+}
+
+static struct io_uring_sqe *cfg__ring_sqe(Cfg_Ring *ring)
+{
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *ring->sq_tail;
+    if (tail - head >= ring->entries) return NULL;
+
+    unsigned idx = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    ring->sq_array[idx] = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+    return sqe;
+}
+
+static bool cfg__ring_enter(Cfg_Ring *ring, unsigned wait)
+{
+    while (true) {
+        long res = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (res < 0 && errno == EINTR) continue;
+        if (res < 0) return false;
+        ring->to_submit -= (unsigned)res;
+        if (ring->to_submit == 0) return true;
+    }
+}
+
+static bool cfg__ring_cqe(Cfg_Ring *ring, uint64_t *user_data, int *res)
+{
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) return false;
+
+    struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+    *user_data = cqe->user_data;
+    *res = cqe->res;
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool cfg__ring_wait(Cfg_Ring *ring, uint64_t *user_data, int *res)
+{
+    while (!cfg__ring_cqe(ring, user_data, res)) {
+        if (!cfg__ring_enter(ring, 1)) return false;
+    }
+    return true;
+}
+
+static void cfg__ring_reap(Cfg_Ring *ring, unsigned opcode, int *fds, bool *busy, size_t len)
+{
+    // Queued entries which were never submitted (`to_submit`) do not complete unless
+    // a later enter submits them
+    size_t inflight = 0;
+    for (size_t i = 0; i < len; ++i) inflight += busy[i];
+
+    struct timespec pause = {0, 1000000};
+    unsigned idle = 0;
+    uint64_t user_data;
+    int res;
+    while (inflight > ring->to_submit && idle < 1000) {
+        if (cfg__ring_cqe(ring, &user_data, &res)) {
+            busy[user_data] = false;
+            if (opcode == IORING_OP_OPENAT) fds[user_data] = res;
+            if (opcode == IORING_OP_CLOSE) fds[user_data] = -1;
+            inflight--;
+            idle = 0;
+        } else if (!cfg__ring_enter(ring, 1)) {
+            // Completions of io-wq workers are posted without enter, keep polling the queue
+            nanosleep(&pause, NULL);
+            idle++;
+        }
+    }
+}
+
+static size_t cfg__load_files_ring(Cfg_Ring *ring, Cfg_Config **cfgs, const char *const *paths, size_t count, size_t *handled)
+{
+    size_t loaded = 0;
+    int fds[FILES_BATCH];
+    char *bufs[FILES_BATCH];
+    size_t lens[FILES_BATCH];
+    bool busy[FILES_BATCH]; // Operation on file is in flight
+    bool done[FILES_BATCH]; // Config is loaded or has error
+    size_t closing[FILES_BATCH];
+    Cfg_Config **batch = cfgs;
+    size_t batch_first = 0;
+    size_t len = 0;
+    bool failed = false;
+    unsigned phase = IORING_OP_OPENAT; // Operations in flight
+    uint64_t user_data;
+    int res;
+
+    *handled = 0;
+    for (size_t first = 0; first < count && !failed; first += FILES_BATCH) {
+        len = count - first < FILES_BATCH ? count - first : FILES_BATCH;
+        batch = cfgs + first;
+        batch_first = first;
+        const char *const *batch_paths = paths + first;
+        unsigned pending = 0;
+        phase = IORING_OP_OPENAT;
+
+        // Open all files of the batch
+        for (size_t i = 0; i < len; ++i) {
+            fds[i] = -1;
+            bufs[i] = NULL;
+            lens[i] = 0;
+            busy[i] = false;
+            done[i] = !batch[i];
+            if (!batch[i]) continue;
+            struct io_uring_sqe *sqe = cfg__ring_sqe(ring);
+            if (!sqe) continue;
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)batch_paths[i];
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = i;
+            busy[i] = true;
+            pending++;
+        }
+        while (pending && !failed) {
+            if (!cfg__ring_wait(ring, &user_data, &res)) {
+                failed = true;
+                break;
+            }
+            busy[user_data] = false;
+            fds[user_data] = res;
+            pending--;
+        }
+
+        // Read every opened file into its buffer until read returns 0, parse each one as soon as it is read
+        if (!failed) phase = IORING_OP_READ;
+        for (size_t i = 0; i < len && !failed; ++i) {
+            if (fds[i] < 0) continue;
+            bufs[i] = cfg__alloc(batch[i], FILE_READ_CHUNK);
+            struct io_uring_sqe *sqe = bufs[i] ? cfg__ring_sqe(ring) : NULL;
+            if (!sqe) {
+                // Read synchronously, reports error if there is no memory
+                size_t cap = bufs[i] ? FILE_READ_CHUNK : 0;
+                if (cfg__file_load_fd(batch[i], fds[i], batch_paths[i], bufs[i], 0, cap) == CFG_ERROR_NONE) loaded++;
+                bufs[i] = NULL;
+                done[i] = true;
+                continue;
+            }
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = fds[i];
+            sqe->addr = (uint64_t)(uintptr_t)bufs[i];
+            sqe->len = FILE_READ_CHUNK - 1;
+            sqe->off = 0;
+            sqe->user_data = i;
+            busy[i] = true;
+            pending++;
+        }
+        while (pending && !failed) {
+            if (!cfg__ring_wait(ring, &user_data, &res)) {
+                failed = true;
+                break;
+            }
+            size_t i = user_data;
+            busy[i] = false;
+            pending--;
+            Cfg_Error_Type err;
+            if (res == 0) {
+                bufs[i][lens[i]] = '\0';
+                err = cfg_load_buffer(batch[i], bufs[i]);
+                cfg__free(batch[i], bufs[i], FILE_READ_CHUNK);
+            } else {
+                if (res > 0) lens[i] += (size_t)res;
+                struct io_uring_sqe *sqe = res > 0 && lens[i] < FILE_READ_CHUNK - 1 ? cfg__ring_sqe(ring) : NULL;
+                if (sqe) {
+                    sqe->opcode = IORING_OP_READ;
+                    sqe->fd = fds[i];
+                    sqe->addr = (uint64_t)(uintptr_t)(bufs[i] + lens[i]);
+                    sqe->len = (unsigned)(FILE_READ_CHUNK - 1 - lens[i]);
+                    sqe->off = lens[i];
+                    sqe->user_data = i;
+                    busy[i] = true;
+                    pending++;
+                    continue;
+                }
+                // Buffer is full or read failed, the rest is read (or error is reported) with pread
+                err = cfg__file_load_fd(batch[i], fds[i], batch_paths[i], bufs[i], lens[i], FILE_READ_CHUNK);
+            }
+            bufs[i] = NULL;
+            done[i] = true;
+            if (err == CFG_ERROR_NONE) loaded++;
+        }
+        if (failed) break;
+
+        // Close all files, files which were not opened are loaded with cfg_load_file,
+        // it reports the error of opening (or loads file if openat is not supported)
+        for (size_t i = 0; i < len; ++i) {
+            if (!batch[i]) continue;
+            if (fds[i] < 0) {
+                if (cfg_load_file(batch[i], batch_paths[i]) == CFG_ERROR_NONE) loaded++;
+                done[i] = true;
+                continue;
+            }
+            struct io_uring_sqe *sqe = cfg__ring_sqe(ring);
+            if (!sqe) {
+                close(fds[i]);
+                continue;
+            }
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = fds[i];
+            sqe->user_data = i;
+            busy[i] = true;
+            closing[pending++] = i;
+        }
+        unsigned queued = pending;
+        while (pending) {
+            if (!cfg__ring_wait(ring, &user_data, &res)) {
+                // All configs of the batch are done. Closes in flight must finish before the ring
+                // is freed (it cancels them), files which were never submitted are closed here
+                cfg__ring_reap(ring, IORING_OP_CLOSE, fds, busy, len);
+                for (unsigned k = queued - ring->to_submit; k < queued; ++k) close(fds[closing[k]]);
+                failed = true;
+                break;
+            }
+            busy[user_data] = false;
+            pending--;
+        }
+        *handled = first + len;
+    }
+
+    if (failed && *handled == batch_first) {
+        // Opens completing after the ring is freed would leave descriptors nobody closes,
+        // reads would write into freed buffers
+        cfg__ring_reap(ring, phase, fds, busy, len);
+
+        // Finish batch without ring, every config gets loaded or gets its error
+        for (size_t i = 0; i < len; ++i) {
+            if (done[i]) {
+                if (fds[i] >= 0) close(fds[i]);
+                continue;
+            }
+            const char *path = paths[batch_first + i];
+            Cfg_Error_Type err;
+            if (fds[i] < 0) {
+                err = cfg_load_file(batch[i], path);
+            } else if (busy[i]) {
+                // Buffer may still be written by read in flight, it is freed after the ring
+                err = cfg__file_load_fd(batch[i], fds[i], path, NULL, 0, 0);
+            } else {
+                err = cfg__file_load_fd(batch[i], fds[i], path, bufs[i], lens[i], bufs[i] ? FILE_READ_CHUNK : 0);
+                bufs[i] = NULL;
+            }
+            if (fds[i] >= 0) close(fds[i]);
+            if (err == CFG_ERROR_NONE) loaded++;
+        }
+        *handled = batch_first + len;
+    }
+
+    cfg__ring_free(ring);
+    for (size_t i = 0; failed && i < len; ++i) {
+        if (busy[i] && bufs[i]) cfg__free(batch[i], bufs[i], FILE_READ_CHUNK);
+    }
+    return loaded;
+}
+#endif
+
 // Public API function definitions
 
-Cfg_Config *cfg_config_init(void)
-{
-    Cfg_Config *cfg = malloc(sizeof(Cfg_Config));
-    cfg->global.vars = malloc(INIT_VARIABLES_NUM * sizeof(Cfg_Variable));
-    if (!cfg || !cfg->global.vars) return NULL;
-    cfg->global.name = NULL;
-    cfg->global.value = NULL;
-    cfg->global.prev = NULL;
-    cfg->global.vars_len = 0;
-    cfg->global.vars_cap = INIT_VARIABLES_NUM;
-    cfg->err.type = CFG_ERROR_NONE;
-    cfg->err.message[0] = '\0';
-    return cfg;
-}
+Cfg_Config *cfg_config_init(void)
+{
+    return cfg_config_init_allocator(NULL);
+}
+
+Cfg_Config *cfg_config_init_allocator(const Cfg_Allocator *allocator)
+{
+    Cfg_Allocator alloc = {
+        .alloc = cfg__default_alloc,
+        .realloc = cfg__default_realloc,
+        .free = cfg__default_free,
+        .ctx = NULL,
+    };
+    if (allocator != NULL) alloc = *allocator;
+
+    Cfg_Config *cfg = alloc.alloc(alloc.ctx, sizeof(Cfg_Config));
+    if (!cfg) return NULL;
+    cfg->allocator = alloc;
+    memset(&cfg->stats, 0, sizeof(Cfg_Stats));
+    memset(&cfg->mem, 0, sizeof(Cfg_MemInfo));
+    cfg->mem.total = sizeof(Cfg_Config);
+    cfg->mem.allocations = 1;
+    cfg->block = NULL;
+    cfg->block_size = 0;
+    if (!cfg__context_alloc(cfg, &cfg->global, INIT_VARIABLES_NUM)) {
+        alloc.free(alloc.ctx, cfg, sizeof(Cfg_Config));
+        return NULL;
+    }
+    cfg->global.type = CFG_TYPE_STRUCT;
+    cfg->global.name = NULL;
+    cfg->global.value = NULL;
+    cfg->global.prev = NULL;
+    cfg->global.string_flags = 0;
+    memset(&cfg->intern, 0, sizeof(Cfg_Intern));
+    cfg->err.type = CFG_ERROR_NONE;
+    cfg->err.message[0] = '\0';
+    cfg->base = NULL;
+    cfg->clones = 0;
+    cfg->released = false;
+    cfg->generation = 0;
+    cfg->file = NULL;
+    cfg->includes = NULL;
+    cfg->includes_len = 0;
+    return cfg;
+}
+
+Cfg_Config *cfg_config_clone(Cfg_Config *cfg)
+{
+    Cfg_Allocator alloc = cfg->allocator;
+    Cfg_Config *clone = alloc.alloc(alloc.ctx, sizeof(Cfg_Config));
+    if (!clone) return NULL;
+    clone->allocator = alloc;
+    memset(&clone->stats, 0, sizeof(Cfg_Stats));
+    memset(&clone->mem, 0, sizeof(Cfg_MemInfo));
+    clone->mem.total = sizeof(Cfg_Config);
+    clone->mem.allocations = 1;
+    clone->block = NULL;
+    clone->block_size = 0;
+    clone->global = cfg->global;
+    clone->global.string_flags = cfg->global.vars != NULL ? CFG_BORROWED_VARS : 0;
+    memset(&clone->intern, 0, sizeof(Cfg_Intern));
+    clone->intern.enabled = cfg->intern.enabled;
+    clone->err.type = CFG_ERROR_NONE;
+    clone->err.message[0] = '\0';
+    clone->base = cfg;
+    clone->clones = 0;
+    clone->released = false;
+    clone->generation = 0;
+    clone->file = NULL;
+    clone->includes = NULL;
+    clone->includes_len = 0;
+    cfg->clones++;
+    return clone;
+}
+
+void cfg_config_deinit(Cfg_Config *cfg)
+{
+    if (!cfg) return;
+    // Tree is still used by clones, the last of them frees config
+    if (cfg->clones > 0) {
+        cfg->released = true;
+        return;
+    }
+    Cfg_Config *base = cfg->base;
+    cfg__context_free(cfg, &cfg->global);
+    cfg__intern_free(cfg);
+    if (cfg->block != NULL) cfg__free(cfg, cfg->block, cfg->block_size);
+    for (size_t i = 0; i < cfg->includes_len; ++i) {
+        cfg__free(cfg, cfg->includes[i].path, strlen(cfg->includes[i].path) + 1);
+    }
+    if (cfg->includes != NULL) cfg__free(cfg, cfg->includes, sizeof(Cfg_Include_Dep) * cfg->includes_len);
+    Cfg_Allocator alloc = cfg->allocator;
+    alloc.free(alloc.ctx, cfg, sizeof(Cfg_Config));
+    if (base != NULL && --base->clones == 0 && base->released) cfg_config_deinit(base);
+}
+
+void cfg_config_intern_values(Cfg_Config *cfg, bool enable)
+{
+    cfg->intern.enabled = enable;
+}
+
+Cfg_Error_Type cfg_config_compact(Cfg_Config *cfg)
+{
+    if (cfg->base != NULL) {
+        cfg->err.type = CFG_ERROR_CONFIG_SHARED;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Clone of config can not be compacted");
+        return cfg->err.type;
+    }
+    if (cfg__frozen(cfg)) return cfg->err.type;
+    cfg->generation++;
+
+    size_t nodes_size = 0;
+    size_t nodes_count = 0;
+    size_t strings_size = 0;
+    cfg__compact_measure(&cfg->global, &nodes_size, &nodes_count, &strings_size);
+
+    size_t names = cfg->mem.names;
+    size_t values = cfg->mem.values;
+    size_t intern_refs = cfg->intern.refs_size;
+    size_t block_size = nodes_size + strings_size;
+    char *block = NULL;
+    if (block_size > 0) {
+        block = cfg__alloc(cfg, block_size);
+        if (!block) {
+            cfg->err.type = CFG_ERROR_NO_MEMORY;
+            sprintf(cfg->err.message, "Failed to allocate memory");
+            return cfg->err.type;
+        }
+    }
+
+    Cfg_Variable old = cfg->global;
+    char *nodes = block;
+    char *strings = block + nodes_size;
+    cfg__compact_copy(&cfg->global, &old, &nodes, &strings);
+
+    // Old tree is released with old block if config was already compacted
+    cfg__context_free(cfg, &old);
+    if (cfg->block != NULL) {
+        cfg->mem.unused -= cfg->block_size;
+        cfg__free(cfg, cfg->block, cfg->block_size);
+    }
+    cfg->block = block;
+    cfg->block_size = block_size;
+
+    cfg->mem.nodes += CFG_SLOT_SIZE * nodes_count;
+    cfg->mem.slack += nodes_size - CFG_SLOT_SIZE * nodes_count;
+    cfg->mem.names += names;
+    cfg->mem.values += values;
+    cfg->intern.refs_size = intern_refs;
 
-void cfg_config_deinit(Cfg_Config *cfg)
-{
-    if (!cfg) return;
-    cfg__context_free(&cfg->global);
-    free(cfg);
+    return CFG_ERROR_NONE;
 }
 
 Cfg_Error_Type cfg_load_buffer(Cfg_Config *cfg, char *buffer)
 {
+#ifdef CFG_STATS
+    uint64_t start = cfg__time_ns();
+#endif
     Cfg_Lexer *lexer = cfg__buffer_tokenize(cfg, buffer);
     if (!lexer) return cfg->err.type;
+#ifdef CFG_STATS
+    uint64_t tokenized = cfg__time_ns();
+#endif
     int res = cfg__parse_tokens(cfg, lexer);
+#ifdef CFG_STATS
+    cfg__stats_load(cfg, lexer, start, tokenized);
+#endif
     cfg__lexer_free(lexer);
     if (res != 0) return cfg->err.type;
     return CFG_ERROR_NONE;
 }
 
+Cfg_Error_Type cfg_load_buffer_path(Cfg_Config *cfg, char *buffer, const char *path)
+{
+    const char *file = cfg->file;
+    cfg->file = path;
+    Cfg_Error_Type err = cfg_load_buffer(cfg, buffer);
+    cfg->file = file;
+    return err;
+}
+
 Cfg_Error_Type cfg_load_stream(Cfg_Config *cfg, FILE *stream)
 {
+#ifdef CFG_STATS
+    uint64_t start = cfg__time_ns();
+#endif
     Cfg_Lexer *lexer = cfg__stream_tokenize(cfg, stream);
     if (!lexer) return cfg->err.type;
+#ifdef CFG_STATS
+    uint64_t tokenized = cfg__time_ns();
+#endif
     int res = cfg__parse_tokens(cfg, lexer);
+#ifdef CFG_STATS
+    cfg__stats_load(cfg, lexer, start, tokenized);
+#endif
     cfg__lexer_free(lexer);
     if (res != 0) return cfg->err.type;
     return CFG_ERROR_NONE;
@@ -1319,11 +4214,70 @@ Cfg_Error_Type cfg_load_file(Cfg_Config *cfg, const char *path)
     }
     fseek(stream, prev, SEEK_SET);
 
+    const char *file = cfg->file;
+    cfg->file = path;
     Cfg_Error_Type err = cfg_load_stream(cfg, stream);
+    cfg->file = file;
     fclose(stream);
     return err;
 }
 
+size_t cfg_load_files(Cfg_Config **cfgs, const char *const *paths, size_t count)
+{
+    size_t loaded = 0;
+    size_t first = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (cfgs[i]) cfgs[i]->file = paths[i];
+    }
+#ifdef CFG_IO_URING
+    Cfg_Ring ring;
+    if (count > 1 && cfg__ring_init(&ring, FILES_BATCH * 2)) {
+        loaded = cfg__load_files_ring(&ring, cfgs, paths, count, &first);
+    }
+#endif
+
+    // Files which were not loaded in io_uring batches
+    for (size_t i = first; i < count; ++i) {
+        if (!cfgs[i]) continue;
+#ifdef CFG_POSIX_IO
+        int fd = open(paths[i], O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            if (cfg__file_load_fd(cfgs[i], fd, paths[i], NULL, 0, 0) == CFG_ERROR_NONE) loaded++;
+            close(fd);
+            continue;
+        }
+#endif
+        if (cfg_load_file(cfgs[i], paths[i]) == CFG_ERROR_NONE) loaded++;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (cfgs[i]) cfgs[i]->file = NULL;
+    }
+    return loaded;
+}
+
+void cfg_include_cache_clear(void)
+{
+    // Unreferenced entries are collected at the start of unlinked array and freed after unlocking
+    cfg__include_lock();
+    Cfg_Include **entries = cfg__includes.entries;
+    size_t unused = 0;
+    for (size_t i = 0; i < cfg__includes.len; ++i) {
+        Cfg_Include *entry = entries[i];
+        if (entry->refs == 0) {
+            entries[unused++] = entry;
+        } else {
+            entry->stale = true;
+        }
+    }
+    cfg__includes.entries = NULL;
+    cfg__includes.len = 0;
+    cfg__includes.cap = 0;
+    cfg__include_unlock();
+
+    for (size_t i = 0; i < unused; ++i) cfg__include_free(entries[i]);
+    CFG_FREE(entries);
+}
+
 Cfg_Variable *cfg_global_context(Cfg_Config *cfg)
 {
     return &cfg->global;
@@ -1332,6 +4286,7 @@ Cfg_Variable *cfg_global_context(Cfg_Config *cfg)
 int cfg_get_int(Cfg_Variable *ctx, const char *name)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_INT);
 
     if (i == -1 || ctx->vars[i].type != CFG_TYPE_INT) {
         return 0;
@@ -1349,6 +4304,7 @@ int cfg_get_int(Cfg_Variable *ctx, const char *name)
 double cfg_get_double(Cfg_Variable *ctx, const char *name)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_DOUBLE);
 
     if (i == -1 || ctx->vars[i].type != CFG_TYPE_DOUBLE) {
         return 0.0;
@@ -1366,6 +4322,7 @@ double cfg_get_double(Cfg_Variable *ctx, const char *name)
 bool cfg_get_bool(Cfg_Variable *ctx, const char *name)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_BOOL);
 
     if (i == -1 || ctx->vars[i].type != CFG_TYPE_BOOL) {
         return false;
@@ -1381,6 +4338,7 @@ bool cfg_get_bool(Cfg_Variable *ctx, const char *name)
 char *cfg_get_string(Cfg_Variable *ctx, const char *name)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_STRING);
 
     if (i == -1 || ctx->vars[i].type != CFG_TYPE_STRING) {
         return NULL;
@@ -1392,6 +4350,7 @@ char *cfg_get_string(Cfg_Variable *ctx, const char *name)
 Cfg_Variable *cfg_get_array(Cfg_Variable *ctx, const char *name)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_ARRAY);
 
     if (i == -1 || ctx->vars[i].type != CFG_TYPE_ARRAY) {
         return NULL;
@@ -1403,6 +4362,7 @@ Cfg_Variable *cfg_get_array(Cfg_Variable *ctx, const char *name)
 Cfg_Variable *cfg_get_list(Cfg_Variable *ctx, const char *name)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_LIST);
 
     if (i == -1 || ctx->vars[i].type != CFG_TYPE_LIST) {
         return NULL;
@@ -1414,6 +4374,7 @@ Cfg_Variable *cfg_get_list(Cfg_Variable *ctx, const char *name)
 Cfg_Variable *cfg_get_struct(Cfg_Variable *ctx, const char *name)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_STRUCT);
 
     if (i == -1 || ctx->vars[i].type != CFG_TYPE_STRUCT) {
         return NULL;
@@ -1425,35 +4386,39 @@ Cfg_Variable *cfg_get_struct(Cfg_Variable *ctx, const char *name)
 Cfg_Error_Type cfg_get_int_safe(Cfg_Variable *ctx, const char *name, int *res)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_INT);
 
     if (i == -1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (ctx->vars[i].type != CFG_TYPE_INT) {
-        ctx->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not int", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not int", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not int", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not int", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (sscanf(ctx->vars[i].value, "%d", res) != 1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_PARSE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_PARSE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Failed to parse variable `%s` in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Failed to parse variable `%s` in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Failed to parse variable `%s`", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Failed to parse variable `%s`", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     return CFG_ERROR_NONE;
@@ -1462,35 +4427,39 @@ Cfg_Error_Type cfg_get_int_safe(Cfg_Variable *ctx, const char *name, int *res)
 Cfg_Error_Type cfg_get_double_safe(Cfg_Variable *ctx, const char *name, double *res)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_DOUBLE);
 
     if (i == -1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (ctx->vars[i].type != CFG_TYPE_DOUBLE) {
-        ctx->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not double", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not double", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not double", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not double", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (sscanf(ctx->vars[i].value, "%lf", res) != 1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_PARSE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_PARSE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Failed to parse variable `%s` in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Failed to parse variable `%s` in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Failed to parse variable `%s`", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Failed to parse variable `%s`", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     return CFG_ERROR_NONE;
@@ -1499,25 +4468,28 @@ Cfg_Error_Type cfg_get_double_safe(Cfg_Variable *ctx, const char *name, double *
 Cfg_Error_Type cfg_get_bool_safe(Cfg_Variable *ctx, const char *name, bool *res)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_BOOL);
 
     if (i == -1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (ctx->vars[i].type != CFG_TYPE_BOOL) {
-        ctx->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not bool", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not bool", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not bool", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not bool", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (strcmp(ctx->vars[i].value, "true") == 0) {
@@ -1532,25 +4504,28 @@ Cfg_Error_Type cfg_get_bool_safe(Cfg_Variable *ctx, const char *name, bool *res)
 Cfg_Error_Type cfg_get_string_safe(Cfg_Variable *ctx, const char *name, char **res)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_STRING);
 
     if (i == -1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (ctx->vars[i].type != CFG_TYPE_STRING) {
-        ctx->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not string", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not string", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not string", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not string", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     *res = ctx->vars[i].value;
@@ -1560,25 +4535,28 @@ Cfg_Error_Type cfg_get_string_safe(Cfg_Variable *ctx, const char *name, char **r
 Cfg_Error_Type cfg_get_array_safe(Cfg_Variable *ctx, const char *name, Cfg_Variable **res)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_ARRAY);
 
     if (i == -1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (ctx->vars[i].type != CFG_TYPE_ARRAY) {
-        ctx->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not array", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not array", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not array", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not array", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     *res = &ctx->vars[i];
@@ -1588,25 +4566,28 @@ Cfg_Error_Type cfg_get_array_safe(Cfg_Variable *ctx, const char *name, Cfg_Varia
 Cfg_Error_Type cfg_get_list_safe(Cfg_Variable *ctx, const char *name, Cfg_Variable **res)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_LIST);
 
     if (i == -1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (ctx->vars[i].type != CFG_TYPE_LIST) {
-        ctx->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not list", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not list", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not list", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not list", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     *res = &ctx->vars[i];
@@ -1616,25 +4597,28 @@ Cfg_Error_Type cfg_get_list_safe(Cfg_Variable *ctx, const char *name, Cfg_Variab
 Cfg_Error_Type cfg_get_struct_safe(Cfg_Variable *ctx, const char *name, Cfg_Variable **res)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_STRUCT);
 
     if (i == -1) {
-        ctx->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found in `%s`", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     if (ctx->vars[i].type != CFG_TYPE_STRUCT) {
-        ctx->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        cfg__context_err.ctx = ctx;
+        cfg__context_err.err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
         if (ctx->name != NULL) {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not struct", name, ctx->name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` in `%s` is not struct", name, ctx->name);
         } else {
-            snprintf(ctx->err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not struct", name);
+            snprintf(cfg__context_err.err.message, ERROR_MESSAGE_LEN, "Variable `%s` is not struct", name);
         }
-        return ctx->err.type;
+        return cfg__context_err.err.type;
     }
 
     *res = &ctx->vars[i];
@@ -1721,12 +4705,31 @@ Cfg_Variable *cfg_get_struct_elem(Cfg_Variable *ctx, size_t idx)
 Cfg_Type cfg_get_type(Cfg_Variable *ctx, const char *name)
 {
     int i = cfg__context_find_variable(ctx, name);
+    cfg__telemetry_record(ctx, name, i, CFG_TYPE_NONE);
 
     if (i == -1) return CFG_TYPE_NONE;
 
     return ctx->vars[i].type;
 }
 
+Cfg_Variable *cfg_find_variable(Cfg_Variable *ctx, const char *name, size_t len)
+{
+    return cfg_find_variable_hashed(ctx, name, len, cfg__hash(name, len));
+}
+
+uint32_t cfg_hash(const char *name, size_t len)
+{
+    return cfg__hash(name, len);
+}
+
+Cfg_Variable *cfg_find_variable_hashed(Cfg_Variable *ctx, const char *name, size_t len, uint32_t hash)
+{
+    int i = cfg__context_find_variable_n(ctx, name, len, hash);
+    if (i == -1) return NULL;
+
+    return &ctx->vars[i];
+}
+
 Cfg_Type cfg_get_type_elem(Cfg_Variable *ctx, size_t idx)
 {
     if (idx >= ctx->vars_len) return CFG_TYPE_NONE;
@@ -1734,6 +4737,112 @@ Cfg_Type cfg_get_type_elem(Cfg_Variable *ctx, size_t idx)
     return ctx->vars[idx].type;
 }
 
+Cfg_Error_Type cfg_set_int(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, int value)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", value);
+    return cfg__set(cfg, ctx, name, CFG_TYPE_INT, buf);
+}
+
+Cfg_Error_Type cfg_set_double(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, double value)
+{
+    char buf[32];
+    cfg__format_double(buf, sizeof(buf), value);
+    return cfg__set(cfg, ctx, name, CFG_TYPE_DOUBLE, buf);
+}
+
+Cfg_Error_Type cfg_set_bool(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, bool value)
+{
+    return cfg__set(cfg, ctx, name, CFG_TYPE_BOOL, value ? "true" : "false");
+}
+
+Cfg_Error_Type cfg_set_string(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name, const char *value)
+{
+    return cfg__set(cfg, ctx, name, CFG_TYPE_STRING, value);
+}
+
+Cfg_Variable *cfg_insert(Cfg_Config *cfg, Cfg_Variable *ctx, Cfg_Type type, const char *name, const char *value)
+{
+    cfg__err_clear(cfg);
+    bool named = ctx->type == CFG_TYPE_STRUCT;
+    bool container = type == CFG_TYPE_ARRAY || type == CFG_TYPE_LIST || type == CFG_TYPE_STRUCT;
+    bool scalar = type == CFG_TYPE_INT || type == CFG_TYPE_DOUBLE || type == CFG_TYPE_BOOL || type == CFG_TYPE_STRING;
+    if (!container && !scalar) {
+        cfg->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Unknown type %d of variable", (int)type);
+        return NULL;
+    }
+    if (named != (name != NULL) || (ctx->type != CFG_TYPE_STRUCT && ctx->type != CFG_TYPE_ARRAY && ctx->type != CFG_TYPE_LIST)) {
+        cfg->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Variables of struct need name and elements of array/list do not");
+        return NULL;
+    }
+    if (name != NULL && !cfg__name_valid(name)) {
+        cfg->err.type = CFG_ERROR_VARIABLE_PARSE;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Invalid name of variable `%s`", name);
+        return NULL;
+    }
+    if (ctx->type == CFG_TYPE_ARRAY && ctx->vars_len > 0 && ctx->vars[0].type != type) {
+        cfg->err.type = CFG_ERROR_VARIABLE_WRONG_TYPE;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Elements of array must have the same type");
+        return NULL;
+    }
+    if (name != NULL && cfg__context_find_variable(ctx, name) != -1) {
+        cfg->err.type = CFG_ERROR_VARIABLE_REDEFINITION;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Redefined variable `%s`", name);
+        return NULL;
+    }
+    if (container ? value != NULL : value == NULL || !cfg__value_valid(type, value)) {
+        cfg->err.type = CFG_ERROR_VARIABLE_PARSE;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Invalid value of variable");
+        return NULL;
+    }
+
+    if (cfg__frozen(cfg)) return NULL;
+    ctx = cfg__context_own(cfg, ctx);
+    if (!ctx) return NULL;
+    cfg->generation++;
+
+    return cfg__context_append(cfg, ctx, type, name, value, 0);
+}
+
+Cfg_Error_Type cfg_remove(Cfg_Config *cfg, Cfg_Variable *ctx, const char *name)
+{
+    cfg__err_clear(cfg);
+    int i = cfg__context_find_variable(ctx, name);
+    if (i == -1) {
+        cfg->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Variable `%s` not found", name);
+        return cfg->err.type;
+    }
+
+    if (cfg__frozen(cfg)) return cfg->err.type;
+    ctx = cfg__context_own(cfg, ctx);
+    if (!ctx) return cfg->err.type;
+    cfg->generation++;
+
+    cfg__context_remove(cfg, ctx, i);
+    return CFG_ERROR_NONE;
+}
+
+Cfg_Error_Type cfg_remove_elem(Cfg_Config *cfg, Cfg_Variable *ctx, size_t idx)
+{
+    cfg__err_clear(cfg);
+    if (idx >= ctx->vars_len) {
+        cfg->err.type = CFG_ERROR_VARIABLE_NOT_FOUND;
+        snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Element %lu not found", (unsigned long)idx);
+        return cfg->err.type;
+    }
+
+    if (cfg__frozen(cfg)) return cfg->err.type;
+    ctx = cfg__context_own(cfg, ctx);
+    if (!ctx) return cfg->err.type;
+    cfg->generation++;
+
+    cfg__context_remove(cfg, ctx, idx);
+    return CFG_ERROR_NONE;
+}
+
 Cfg_Error_Type cfg_err_type(Cfg_Config *cfg)
 {
     return cfg->err.type;
@@ -1746,16 +4855,476 @@ char *cfg_err_message(Cfg_Config *cfg)
     return cfg->err.message;
 }
 
+void cfg_memory_usage(Cfg_Config *cfg, Cfg_MemInfo *info)
+{
+    *info = cfg->mem;
+    info->lexer = cfg->mem.total - sizeof(Cfg_Config) - cfg->mem.nodes - cfg->mem.names
+                - cfg->mem.values - cfg->mem.slack - cfg->mem.unused - cfg->mem.interned - cfg->mem.includes;
+    info->intern_saved = 0;
+    if (cfg->intern.refs_size > cfg->intern.strings_size) {
+        info->intern_saved = cfg->intern.refs_size - cfg->intern.strings_size;
+    }
+}
+
+const Cfg_Stats *cfg_stats(Cfg_Config *cfg)
+{
+#ifdef CFG_STATS
+    return &cfg->stats;
+#else
+    (void)cfg;
+    return NULL;
+#endif
+}
+
+void cfg_telemetry_dump(Cfg_Config *cfg, FILE *out)
+{
+#ifdef CFG_TELEMETRY
+    size_t slots_len = 0;
+    Cfg_Telemetry_Slot **slots = CFG_MALLOC(sizeof(Cfg_Telemetry_Slot *) * CFG_TELEMETRY_SLOTS);
+    if (!slots) return;
+    for (size_t i = 0; i < CFG_TELEMETRY_SLOTS; ++i) {
+        if (cfg__atomic_load(&cfg__telemetry_slots[i].ready, CFG_ACQUIRE)) {
+            slots[slots_len++] = &cfg__telemetry_slots[i];
+        }
+    }
+    qsort(slots, slots_len, sizeof(Cfg_Telemetry_Slot *), cfg__telemetry_compare);
+
+    char path[ERROR_MESSAGE_LEN] = {0};
+    fprintf(out, "%12s %12s %12s  %s\n", "hits", "misses", "wrong_type", "key");
+    cfg__telemetry_dump_context(&cfg->global, out, path, 0, slots, slots_len);
+
+    uint64_t dropped = cfg__atomic_load(&cfg__telemetry_dropped, CFG_RELAXED);
+    if (dropped > 0) {
+        fprintf(out, "%llu lookups were not recorded, increase CFG_TELEMETRY_SLOTS\n", (unsigned long long)dropped);
+    }
+    CFG_FREE(slots);
+#else
+    (void)cfg;
+    (void)out;
+#endif
+}
+
+void cfg_telemetry_reset(void)
+{
+#ifdef CFG_TELEMETRY
+    memset(cfg__telemetry_slots, 0, sizeof(cfg__telemetry_slots));
+    cfg__telemetry_dropped = 0;
+#endif
+}
+
+Cfg_Image *cfg_image_build(Cfg_Config *cfg)
+{
+    size_t nodes_count = 1; // Global context
+    size_t strings_size = 0;
+    cfg__image_measure(&cfg->global, &nodes_count, &strings_size);
+
+    if (nodes_count > UINT32_MAX >> CFG_IMAGE_TYPE_BITS || strings_size > UINT32_MAX) {
+        cfg->err.type = CFG_ERROR_NO_MEMORY;
+        sprintf(cfg->err.message, "Config is too large for image");
+        return NULL;
+    }
+
+    size_t size = sizeof(Cfg_Image) + sizeof(Cfg_Image_Header)
+                + (sizeof(Cfg_Image_Node) + sizeof(uint32_t)) * nodes_count + strings_size;
+    Cfg_Image *image = cfg->allocator.alloc(cfg->allocator.ctx, size);
+    if (!image) {
+        cfg->err.type = CFG_ERROR_NO_MEMORY;
+        sprintf(cfg->err.message, "Failed to allocate memory");
+        return NULL;
+    }
+
+    // Image data starts right after Cfg_Image and does not contain pointers,
+    // so it can be copied or mapped anywhere as is
+    Cfg_Image_Header *header = (Cfg_Image_Header *)(image + 1);
+    header->magic = CFG_IMAGE_MAGIC;
+    header->version = CFG_IMAGE_VERSION;
+    header->nodes_len = (uint32_t)nodes_count;
+    header->strings_size = (uint32_t)strings_size;
+
+    Cfg_Image_Node *nodes = (Cfg_Image_Node *)(header + 1);
+    uint32_t *hashes = (uint32_t *)(nodes + nodes_count);
+    char *strings = (char *)(hashes + nodes_count);
+
+    uint32_t next_node = 1;
+    uint32_t next_string = 0;
+    nodes[0].name = CFG_IMAGE_NO_NAME;
+    nodes[0].info = cfg__image_type_code(CFG_TYPE_STRUCT) | (uint32_t)cfg->global.vars_len << CFG_IMAGE_TYPE_BITS;
+    hashes[0] = 0;
+    cfg__image_copy(nodes, hashes, strings, 0, &cfg->global, &next_node, &next_string);
+
+    cfg__image_init(image, header, size - sizeof(Cfg_Image));
+    image->allocator = cfg->allocator;
+    image->shared = false;
+    return image;
+}
+
+void cfg_image_free(Cfg_Image *image)
+{
+    if (!image) return;
+    Cfg_Allocator alloc = image->allocator;
+    if (image->shared) {
+#ifdef CFG_POSIX_IO
+        munmap(image->data, image->size);
+#endif
+        alloc.free(alloc.ctx, image, sizeof(Cfg_Image));
+        return;
+    }
+    alloc.free(alloc.ctx, image, sizeof(Cfg_Image) + image->size);
+}
+
+int cfg_image_share(const Cfg_Image *image)
+{
+#ifdef CFG_POSIX_IO
+    if (!image) return -1;
+    int fd = cfg__shared_fd();
+    if (fd < 0) return -1;
+
+    const char *data = image->data;
+    size_t done = 0;
+    bool ok = ftruncate(fd, (off_t)image->size) == 0;
+    while (ok && done < image->size) {
+        ssize_t res = pwrite(fd, data + done, image->size - done, (off_t)done);
+        if (res < 0 && errno == EINTR) continue;
+        ok = res > 0;
+        if (ok) done += (size_t)res;
+    }
+    if (!ok) {
+        close(fd);
+        return -1;
+    }
+#ifdef F_ADD_SEALS
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+#endif
+    return fd;
+#else
+    (void)image;
+    return -1;
+#endif
+}
+
+Cfg_Image *cfg_attach_shared(int fd)
+{
+#ifdef CFG_POSIX_IO
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Cfg_Image_Header)) return NULL;
+
+    size_t size = (size_t)st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) return NULL;
+
+    // Sizes in header must match size of the file, nodes are checked once here so readers can trust them
+    const Cfg_Image_Header *header = data;
+    size_t expected = sizeof(Cfg_Image_Header)
+                    + (sizeof(Cfg_Image_Node) + sizeof(uint32_t)) * (size_t)header->nodes_len + header->strings_size;
+    Cfg_Image *image = NULL;
+    if (header->magic == CFG_IMAGE_MAGIC && header->version == CFG_IMAGE_VERSION
+        && header->nodes_len > 0 && expected == size) {
+        image = cfg__default_alloc(NULL, sizeof(Cfg_Image));
+    }
+    if (image) {
+        cfg__image_init(image, header, size);
+        if (!cfg__image_valid(image)) {
+            cfg__default_free(NULL, image, sizeof(Cfg_Image));
+            image = NULL;
+        }
+    }
+    if (!image) {
+        munmap(data, size);
+        return NULL;
+    }
+
+    image->allocator.alloc = cfg__default_alloc;
+    image->allocator.realloc = cfg__default_realloc;
+    image->allocator.free = cfg__default_free;
+    image->allocator.ctx = NULL;
+    image->shared = true;
+    return image;
+#else
+    (void)fd;
+    return NULL;
+#endif
+}
+
+Cfg_Node cfg_image_root(const Cfg_Image *image)
+{
+    Cfg_Node node = {image, image != NULL ? 0 : CFG_IMAGE_NO_NODE};
+    return node;
+}
+
+bool cfg_node_valid(Cfg_Node node)
+{
+    return cfg__node(node) != NULL;
+}
+
+Cfg_Type cfg_node_type(Cfg_Node node)
+{
+    const Cfg_Image_Node *n = cfg__node(node);
+    if (!n) return CFG_TYPE_NONE;
+
+    uint32_t code = n->info & ((1u << CFG_IMAGE_TYPE_BITS) - 1);
+    return code > 0 ? (Cfg_Type)(1u << (code - 1)) : CFG_TYPE_NONE;
+}
+
+size_t cfg_node_len(Cfg_Node node)
+{
+    const Cfg_Image_Node *n = cfg__node(node);
+    if (!n) return 0;
+
+    return n->info >> CFG_IMAGE_TYPE_BITS;
+}
+
+const char *cfg_node_name(Cfg_Node node)
+{
+    const Cfg_Image_Node *n = cfg__node(node);
+    if (!n || n->name == CFG_IMAGE_NO_NAME) return NULL;
+
+    return node.image->strings + n->name;
+}
+
+Cfg_Node cfg_node_get(Cfg_Node ctx, const char *name)
+{
+    Cfg_Node res = {ctx.image, CFG_IMAGE_NO_NODE};
+    const Cfg_Image_Node *n = cfg__node(ctx);
+    if (!n) return res;
+
+    uint32_t len = n->info >> CFG_IMAGE_TYPE_BITS;
+    uint32_t hash = cfg__hash(name, strlen(name));
+    const uint32_t *hashes = ctx.image->hashes + n->value;
+    const Cfg_Image_Node *nodes = ctx.image->nodes + n->value;
+    for (uint32_t i = 0; i < len; ++i) {
+        if (hashes[i] == hash && nodes[i].name != CFG_IMAGE_NO_NAME
+            && strcmp(name, ctx.image->strings + nodes[i].name) == 0) {
+            res.idx = n->value + i;
+            return res;
+        }
+    }
+    return res;
+}
+
+Cfg_Node cfg_node_elem(Cfg_Node ctx, size_t idx)
+{
+    Cfg_Node res = {ctx.image, CFG_IMAGE_NO_NODE};
+    const Cfg_Image_Node *n = cfg__node(ctx);
+    if (!n || idx >= n->info >> CFG_IMAGE_TYPE_BITS) return res;
+
+    res.idx = n->value + (uint32_t)idx;
+    return res;
+}
+
+int cfg_node_int(Cfg_Node node)
+{
+    const char *value = cfg__node_value(node, CFG_TYPE_INT);
+    int res;
+
+    if (!value || sscanf(value, "%d", &res) != 1) {
+        return 0;
+    }
+
+    return res;
+}
+
+double cfg_node_double(Cfg_Node node)
+{
+    const char *value = cfg__node_value(node, CFG_TYPE_DOUBLE);
+    double res;
+
+    if (!value || sscanf(value, "%lf", &res) != 1) {
+        return 0.0;
+    }
+
+    return res;
+}
+
+bool cfg_node_bool(Cfg_Node node)
+{
+    const char *value = cfg__node_value(node, CFG_TYPE_BOOL);
+
+    return value != NULL && strcmp(value, "true") == 0;
+}
+
+const char *cfg_node_string(Cfg_Node node)
+{
+    return cfg__node_value(node, CFG_TYPE_STRING);
+}
+
+Cfg_Overlay *cfg_overlay_init(void)
+{
+    Cfg_Overlay *overlay = CFG_MALLOC(sizeof(Cfg_Overlay));
+    if (!overlay) return NULL;
+    memset(overlay, 0, sizeof(Cfg_Overlay));
+    return overlay;
+}
+
+void cfg_overlay_deinit(Cfg_Overlay *overlay)
+{
+    if (!overlay) return;
+    for (size_t i = 0; i < overlay->cache_cap; ++i) CFG_FREE(overlay->cache[i].path);
+    CFG_FREE(overlay->cache);
+    CFG_FREE(overlay->layers);
+    CFG_FREE(overlay->generations);
+    CFG_FREE(overlay);
+}
+
+bool cfg_overlay_push(Cfg_Overlay *overlay, Cfg_Config *cfg)
+{
+    if (overlay->layers_len == overlay->layers_cap) {
+        size_t cap = overlay->layers_cap > 0 ? overlay->layers_cap * 2 : 4;
+        Cfg_Config **layers = CFG_REALLOC(overlay->layers, sizeof(Cfg_Config *) * cap);
+        if (!layers) return false;
+        overlay->layers = layers;
+        size_t *generations = CFG_REALLOC(overlay->generations, sizeof(size_t) * cap);
+        if (!generations) return false;
+        overlay->generations = generations;
+        overlay->layers_cap = cap;
+    }
+    overlay->layers[overlay->layers_len] = cfg;
+    overlay->generations[overlay->layers_len] = cfg->generation;
+    overlay->layers_len++;
+    overlay->stamp++;
+    return true;
+}
+
+void cfg_overlay_set_layer(Cfg_Overlay *overlay, size_t idx, Cfg_Config *cfg)
+{
+    if (idx >= overlay->layers_len) return;
+    overlay->layers[idx] = cfg;
+    overlay->generations[idx] = cfg->generation;
+    overlay->stamp++;
+}
+
+Cfg_Variable *cfg_overlay_find(Cfg_Overlay *overlay, const char *path)
+{
+    cfg__overlay_sync(overlay);
+    size_t len = strlen(path);
+    uint32_t hash = cfg__hash(path, len);
+    // Keep load factor under 3/4, lookups are not cached if there is no memory
+    if ((overlay->cache_len + 1) * 4 > overlay->cache_cap * 3 && !cfg__overlay_grow(overlay)) {
+        return cfg__overlay_resolve(overlay, path, len);
+    }
+
+    size_t i = hash & (overlay->cache_cap - 1);
+    while (overlay->cache[i].path != NULL) {
+        Cfg_Overlay_Entry *entry = &overlay->cache[i];
+        if (entry->hash == hash && strcmp(entry->path, path) == 0) {
+            if (entry->stamp != overlay->stamp) {
+                entry->var = cfg__overlay_resolve(overlay, path, len);
+                entry->stamp = overlay->stamp;
+            }
+            return entry->var;
+        }
+        i = (i + 1) & (overlay->cache_cap - 1);
+    }
+
+    Cfg_Variable *var = cfg__overlay_resolve(overlay, path, len);
+    char *copy = CFG_MALLOC(len + 1);
+    if (!copy) return var;
+    memcpy(copy, path, len + 1);
+    overlay->cache[i].path = copy;
+    overlay->cache[i].hash = hash;
+    overlay->cache[i].stamp = overlay->stamp;
+    overlay->cache[i].var = var;
+    overlay->cache_len++;
+    return var;
+}
+
+Cfg_Type cfg_overlay_get_type(Cfg_Overlay *overlay, const char *path)
+{
+    Cfg_Variable *var = cfg_overlay_find(overlay, path);
+    return var != NULL ? var->type : CFG_TYPE_NONE;
+}
+
+int cfg_overlay_get_int(Cfg_Overlay *overlay, const char *path)
+{
+    Cfg_Variable *var = cfg_overlay_find(overlay, path);
+    int res = 0;
+    if (var == NULL || var->type != CFG_TYPE_INT || sscanf(var->value, "%d", &res) != 1) return 0;
+
+    return res;
+}
+
+double cfg_overlay_get_double(Cfg_Overlay *overlay, const char *path)
+{
+    Cfg_Variable *var = cfg_overlay_find(overlay, path);
+    double res = 0.0;
+    if (var == NULL || var->type != CFG_TYPE_DOUBLE || sscanf(var->value, "%lf", &res) != 1) return 0.0;
+
+    return res;
+}
+
+bool cfg_overlay_get_bool(Cfg_Overlay *overlay, const char *path)
+{
+    Cfg_Variable *var = cfg_overlay_find(overlay, path);
+
+    return var != NULL && var->type == CFG_TYPE_BOOL && strcmp(var->value, "true") == 0;
+}
+
+char *cfg_overlay_get_string(Cfg_Overlay *overlay, const char *path)
+{
+    Cfg_Variable *var = cfg_overlay_find(overlay, path);
+    if (var == NULL || var->type != CFG_TYPE_STRING) return NULL;
+
+    return var->value;
+}
+
+Cfg_Error_Type cfg_overlay_push_env(Cfg_Overlay *overlay, Cfg_Config *cfg, const char *prefix, char **envp)
+{
+    Cfg_Env_Map map = {0};
+    char name[ENV_NAME_MAX];
+    for (size_t i = overlay->layers_len; i-- > 0;) {
+        if (!cfg__env_map_context(cfg, &map, &overlay->layers[i]->global, name, 0)) {
+            cfg__env_map_free(cfg, &map);
+            cfg->err.type = CFG_ERROR_NO_MEMORY;
+            sprintf(cfg->err.message, "Failed to allocate memory");
+            return cfg->err.type;
+        }
+    }
+
+    Cfg_Error_Type res = CFG_ERROR_NONE;
+    size_t prefix_len = strlen(prefix);
+    if (envp == NULL) envp = CFG_ENVIRON;
+    for (char **env = envp; env != NULL && *env != NULL; ++env) {
+        const char *eq = strchr(*env, '=');
+        if (eq == NULL || strncmp(*env, prefix, prefix_len) != 0) continue;
+        const char *path = *env + prefix_len;
+        size_t len = eq - path;
+        Cfg_Variable *var = cfg__env_map_find(&map, path, len, cfg__hash(path, len));
+        if (var == NULL) continue;
+
+        char buf[32];
+        const char *value = cfg__env_convert(var->type, eq + 1, buf, sizeof(buf));
+        Cfg_Error_Type err = CFG_ERROR_VARIABLE_PARSE;
+        if (value != NULL) err = cfg__env_set(cfg, var, value);
+        if (err != CFG_ERROR_NONE && res == CFG_ERROR_NONE) {
+            res = err;
+            if (err == CFG_ERROR_VARIABLE_PARSE) {
+                cfg->err.type = err;
+                snprintf(cfg->err.message, ERROR_MESSAGE_LEN, "Failed to convert environment variable `%.*s`",
+                         (int)(eq - *env), *env);
+            }
+        }
+    }
+    cfg__env_map_free(cfg, &map);
+
+    if (!cfg_overlay_push(overlay, cfg)) {
+        cfg->err.type = CFG_ERROR_NO_MEMORY;
+        sprintf(cfg->err.message, "Failed to allocate memory");
+        return cfg->err.type;
+    }
+    return res;
+}
+
 Cfg_Error_Type cfg_context_err_type(Cfg_Variable *ctx)
 {
-    return ctx->err.type;
+    if (cfg__context_err.ctx != ctx) return CFG_ERROR_NONE;
+
+    return cfg__context_err.err.type;
 }
 
 char *cfg_context_err_message(Cfg_Variable *ctx)
 {
-    if (ctx->err.type == CFG_ERROR_NONE) return NULL;
+    if (cfg__context_err.ctx != ctx || cfg__context_err.err.type == CFG_ERROR_NONE) return NULL;
 
-    return ctx->err.message;
+    return cfg__context_err.err.message;
 }
 
 #endif // CFG_IMPLEMENTATION
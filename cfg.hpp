@@ -0,0 +1,1225 @@
+/*
+ *  cfg.hpp - C++ wrapper of cfg.h - https://github.com/speckitor/cfg.h
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 Pavel Loginov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+// Header only wrapper over the C API, requires C++20
+// The implementation of cfg.h is C: define CFG_IMPLEMENTATION and include cfg.h
+// in one C source file (or compile it with `cc -c -x c -DCFG_IMPLEMENTATION cfg.h`).
+// Handles, ranges and lookups are inline calls of the C core and do not allocate.
+// Config allocates through the C core (or a memory resource), struct binding fills
+// std::string/std::vector fields and `load` reads the file into a std::string.
+// Asynchronous loading (threads, task queue, read buffers) is compiled only when
+// CFG_HPP_ASYNC is defined before including this header.
+
+#ifndef CFG_HPP_
+#define CFG_HPP_
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#ifdef CFG_HPP_ASYNC
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#if __has_include(<unistd.h>)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CFG_HPP_PREAD
+#endif
+#endif
+
+#include "cfg.h"
+
+namespace cfg {
+
+enum class Type {
+    None = CFG_TYPE_NONE,
+    Int = CFG_TYPE_INT,
+    Double = CFG_TYPE_DOUBLE,
+    Bool = CFG_TYPE_BOOL,
+    String = CFG_TYPE_STRING,
+    Array = CFG_TYPE_ARRAY,
+    List = CFG_TYPE_LIST,
+    Struct = CFG_TYPE_STRUCT,
+};
+
+// Same hash as `cfg_hash` (32-bit FNV-1a), usable at compile time
+constexpr std::uint32_t hash(std::string_view name) noexcept
+{
+    std::uint32_t res = 2166136261u;
+    for (char ch : name) {
+        res ^= static_cast<unsigned char>(ch);
+        res *= 16777619u;
+    }
+    return res;
+}
+
+// Variable name with precomputed hash, see `_k` literal
+// Lookups by Key only compare hashes and the matching name at runtime
+struct Key {
+    std::string_view name;
+    std::uint32_t hash;
+
+    consteval Key(std::string_view name) : name(name), hash(cfg::hash(name)) {}
+};
+
+template <typename T>
+class Range;
+struct Item;
+
+// Handle of variable (or of global context), trivially copyable
+// Empty handle is returned when there is no such variable
+class Node {
+public:
+    constexpr Node() noexcept = default;
+    constexpr explicit Node(Cfg_Variable *var) noexcept : var_(var) {}
+
+    constexpr explicit operator bool() const noexcept { return var_ != nullptr; }
+    constexpr Cfg_Variable *c_ptr() const noexcept { return var_; }
+
+    Type type() const noexcept { return var_ ? static_cast<Type>(var_->type) : Type::None; }
+    bool is_container() const noexcept
+    {
+        return var_ && (var_->type & (CFG_TYPE_ARRAY | CFG_TYPE_LIST | CFG_TYPE_STRUCT));
+    }
+
+    // Name of variable, empty for array/list elements and global context
+    std::string_view name() const noexcept
+    {
+        return var_ && var_->name ? std::string_view(var_->name) : std::string_view();
+    }
+
+    // Number of inner variables
+    std::size_t size() const noexcept { return var_ ? var_->vars_len : 0; }
+
+    // Inner variable by name/index
+    Node operator[](std::string_view name) const noexcept
+    {
+        return var_ ? Node(cfg_find_variable(var_, name.data(), name.size())) : Node();
+    }
+    Node operator[](Key key) const noexcept
+    {
+        return var_ ? Node(cfg_find_variable_hashed(var_, key.name.data(), key.name.size(), key.hash)) : Node();
+    }
+    Node at(std::size_t idx) const noexcept
+    {
+        return var_ && idx < var_->vars_len ? Node(&var_->vars[idx]) : Node();
+    }
+
+    // Inner variables, `for (cfg::Node node : ctx)`
+    Range<Node> children() const noexcept;
+    auto begin() const noexcept;
+    auto end() const noexcept;
+
+    // Inner variables with their names, `for (auto [name, node] : ctx.items())`
+    Range<Item> items() const noexcept;
+
+    // Values of elements of array (int, double, bool or std::string_view),
+    // type is checked once, range is empty if this is not an array of T.
+    // With T = cfg::Value works for any container
+    template <typename T>
+    Range<T> values() const noexcept;
+
+    // Value of this node
+    // T is int, double, bool, std::string_view or Node (array/list/struct),
+    // std::nullopt if node is empty or has another type
+    template <typename T>
+    std::optional<T> get() const noexcept;
+
+    // Value of inner variable by name/index
+    template <typename T>
+    std::optional<T> get(std::string_view name) const noexcept { return (*this)[name].template get<T>(); }
+    template <typename T>
+    std::optional<T> get(Key key) const noexcept { return (*this)[key].template get<T>(); }
+    template <typename T>
+    std::optional<T> get(std::size_t idx) const noexcept { return at(idx).template get<T>(); }
+
+    friend constexpr bool operator==(Node a, Node b) noexcept { return a.var_ == b.var_; }
+
+private:
+    Cfg_Variable *var_ = nullptr;
+};
+
+template <>
+inline std::optional<int> Node::get<int>() const noexcept
+{
+    if (type() != Type::Int) return std::nullopt;
+
+    std::string_view value(var_->value);
+    int res;
+    auto [end, err] = std::from_chars(value.data(), value.data() + value.size(), res);
+    if (err != std::errc()) return std::nullopt;
+
+    return res;
+}
+
+template <>
+inline std::optional<double> Node::get<double>() const noexcept
+{
+    if (type() != Type::Double) return std::nullopt;
+
+    char *end;
+    double res = std::strtod(var_->value, &end);
+    if (end == var_->value) return std::nullopt;
+
+    return res;
+}
+
+template <>
+inline std::optional<bool> Node::get<bool>() const noexcept
+{
+    if (type() != Type::Bool) return std::nullopt;
+
+    return std::string_view(var_->value) == "true";
+}
+
+template <>
+inline std::optional<std::string_view> Node::get<std::string_view>() const noexcept
+{
+    if (type() != Type::String) return std::nullopt;
+
+    return std::string_view(var_->value);
+}
+
+template <>
+inline std::optional<Node> Node::get<Node>() const noexcept
+{
+    if (!is_container()) return std::nullopt;
+
+    return *this;
+}
+
+// Value of list element (or any variable), std::monostate for empty nodes
+using Value = std::variant<std::monostate, int, double, bool, std::string_view, Node>;
+
+// Inner variable with its name, name is empty for array/list elements
+struct Item {
+    std::string_view name;
+    Node value;
+};
+
+namespace detail {
+
+// Conversion of variable to element of Range, types are checked by the range
+template <typename T>
+struct Element;
+
+template <>
+struct Element<Node> {
+    static Node get(Cfg_Variable *var) noexcept { return Node(var); }
+};
+
+template <>
+struct Element<Item> {
+    static Item get(Cfg_Variable *var) noexcept
+    {
+        return {var->name ? std::string_view(var->name) : std::string_view(), Node(var)};
+    }
+};
+
+template <>
+struct Element<int> {
+    static constexpr Cfg_Type type = CFG_TYPE_INT;
+    static int get(Cfg_Variable *var) noexcept
+    {
+        std::string_view value(var->value);
+        int res = 0;
+        std::from_chars(value.data(), value.data() + value.size(), res);
+        return res;
+    }
+};
+
+template <>
+struct Element<double> {
+    static constexpr Cfg_Type type = CFG_TYPE_DOUBLE;
+    static double get(Cfg_Variable *var) noexcept { return std::strtod(var->value, nullptr); }
+};
+
+template <>
+struct Element<bool> {
+    static constexpr Cfg_Type type = CFG_TYPE_BOOL;
+    static bool get(Cfg_Variable *var) noexcept { return var->value[0] == 't'; }
+};
+
+template <>
+struct Element<std::string_view> {
+    static constexpr Cfg_Type type = CFG_TYPE_STRING;
+    static std::string_view get(Cfg_Variable *var) noexcept { return var->value; }
+};
+
+template <>
+struct Element<Value> {
+    static Value get(Cfg_Variable *var) noexcept
+    {
+        switch (var->type) {
+        case CFG_TYPE_INT: return Element<int>::get(var);
+        case CFG_TYPE_DOUBLE: return Element<double>::get(var);
+        case CFG_TYPE_BOOL: return Element<bool>::get(var);
+        case CFG_TYPE_STRING: return Element<std::string_view>::get(var);
+        default: return Node(var);
+        }
+    }
+};
+
+} // namespace detail
+
+// Random access iterator over inner variables of context, wraps pointer to variable
+// Dereferencing converts variable to T (Node, Item, Value or value of typed array)
+template <typename T>
+class Iterator {
+public:
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::input_iterator_tag; // Elements are returned by value
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = T;
+
+    constexpr Iterator() noexcept = default;
+    constexpr explicit Iterator(Cfg_Variable *var) noexcept : var_(var) {}
+
+    T operator*() const noexcept { return detail::Element<T>::get(var_); }
+    T operator[](difference_type n) const noexcept { return detail::Element<T>::get(var_ + n); }
+
+    constexpr Iterator &operator++() noexcept { ++var_; return *this; }
+    constexpr Iterator operator++(int) noexcept { return Iterator(var_++); }
+    constexpr Iterator &operator--() noexcept { --var_; return *this; }
+    constexpr Iterator operator--(int) noexcept { return Iterator(var_--); }
+    constexpr Iterator &operator+=(difference_type n) noexcept { var_ += n; return *this; }
+    constexpr Iterator &operator-=(difference_type n) noexcept { var_ -= n; return *this; }
+
+    friend constexpr Iterator operator+(Iterator it, difference_type n) noexcept { return it += n; }
+    friend constexpr Iterator operator+(difference_type n, Iterator it) noexcept { return it += n; }
+    friend constexpr Iterator operator-(Iterator it, difference_type n) noexcept { return it -= n; }
+    friend constexpr difference_type operator-(Iterator a, Iterator b) noexcept { return a.var_ - b.var_; }
+    friend constexpr auto operator<=>(Iterator a, Iterator b) noexcept = default;
+
+    constexpr Cfg_Variable *c_ptr() const noexcept { return var_; }
+
+private:
+    Cfg_Variable *var_ = nullptr;
+};
+
+// View of inner variables of context, works with std::ranges algorithms
+template <typename T>
+class Range : public std::ranges::view_interface<Range<T>> {
+public:
+    constexpr Range() noexcept = default;
+    constexpr Range(Cfg_Variable *first, Cfg_Variable *last) noexcept : first_(first), last_(last) {}
+
+    constexpr Iterator<T> begin() const noexcept { return Iterator<T>(first_); }
+    constexpr Iterator<T> end() const noexcept { return Iterator<T>(last_); }
+
+private:
+    Cfg_Variable *first_ = nullptr;
+    Cfg_Variable *last_ = nullptr;
+};
+
+inline Range<Node> Node::children() const noexcept
+{
+    if (!var_ || !var_->vars) return {};
+    return {var_->vars, var_->vars + var_->vars_len};
+}
+
+inline auto Node::begin() const noexcept { return children().begin(); }
+inline auto Node::end() const noexcept { return children().end(); }
+
+inline Range<Item> Node::items() const noexcept
+{
+    if (!var_ || !var_->vars) return {};
+    return {var_->vars, var_->vars + var_->vars_len};
+}
+
+template <typename T>
+Range<T> Node::values() const noexcept
+{
+    if (!var_ || !var_->vars) return {};
+    if constexpr (std::is_same_v<T, Value>) {
+        return {var_->vars, var_->vars + var_->vars_len};
+    } else {
+        if (var_->type != CFG_TYPE_ARRAY || (var_->vars_len > 0 && var_->vars[0].type != detail::Element<T>::type)) {
+            return {};
+        }
+        return {var_->vars, var_->vars + var_->vars_len};
+    }
+}
+
+namespace detail {
+
+inline void *pmr_alloc(void *ctx, std::size_t size) noexcept
+{
+    try {
+        return static_cast<std::pmr::memory_resource *>(ctx)->allocate(size, alignof(std::max_align_t));
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+inline void pmr_free(void *ctx, void *ptr, std::size_t size) noexcept
+{
+    static_cast<std::pmr::memory_resource *>(ctx)->deallocate(ptr, size, alignof(std::max_align_t));
+}
+
+} // namespace detail
+
+// C allocator hooks backed by memory resource, resource must outlive the config
+// Realloc is left to cfg.h (allocate, copy and free)
+inline Cfg_Allocator allocator(std::pmr::memory_resource *resource) noexcept
+{
+    return {detail::pmr_alloc, nullptr, detail::pmr_free, resource};
+}
+
+// Owning wrapper of Cfg_Config, move-only
+// Config is empty (false) only if it was moved from or initialization failed
+class Config {
+public:
+    Config() noexcept : cfg_(cfg_config_init()) {}
+    // Empty config, nothing is allocated
+    explicit Config(std::nullptr_t) noexcept {}
+    explicit Config(const Cfg_Allocator &allocator) noexcept : cfg_(cfg_config_init_allocator(&allocator)) {}
+    // All memory of config (tree, strings, tokenizer) comes from `resource`
+    explicit Config(std::pmr::memory_resource *resource) noexcept : Config(cfg::allocator(resource)) {}
+    ~Config() { cfg_config_deinit(cfg_); }
+
+    Config(const Config &) = delete;
+    Config &operator=(const Config &) = delete;
+
+    Config(Config &&other) noexcept : cfg_(std::exchange(other.cfg_, nullptr)) {}
+    Config &operator=(Config &&other) noexcept
+    {
+        if (this != &other) {
+            cfg_config_deinit(cfg_);
+            cfg_ = std::exchange(other.cfg_, nullptr);
+        }
+        return *this;
+    }
+
+    explicit operator bool() const noexcept { return cfg_ != nullptr; }
+    Cfg_Config *c_ptr() const noexcept { return cfg_; }
+
+    // Drop config without walking the tree to free it, config becomes empty.
+    // Only for configs on a memory resource that is released as a whole
+    // (e.g. std::pmr::monotonic_buffer_resource), otherwise memory leaks
+    void release() noexcept { cfg_ = nullptr; }
+
+    // Loading, see cfg_load_* functions
+    // `buffer` must be zero-terminated
+    Cfg_Error_Type load_buffer(char *buffer) noexcept { return cfg_load_buffer(cfg_, buffer); }
+    Cfg_Error_Type load_buffer(char *buffer, const char *path) noexcept { return cfg_load_buffer_path(cfg_, buffer, path); }
+    Cfg_Error_Type load_stream(std::FILE *stream) noexcept { return cfg_load_stream(cfg_, stream); }
+    Cfg_Error_Type load_file(const char *path) noexcept { return cfg_load_file(cfg_, path); }
+
+    Cfg_Error_Type compact() noexcept { return cfg_config_compact(cfg_); }
+
+    // Copy-on-write clone sharing tree with this config, see cfg_config_clone
+    // Empty if there is no memory
+    Config clone() const noexcept
+    {
+        Config res(nullptr);
+        if (cfg_) res.cfg_ = cfg_config_clone(cfg_);
+        return res;
+    }
+
+    Cfg_Error_Type error() const noexcept { return cfg_err_type(cfg_); }
+    std::string_view error_message() const noexcept
+    {
+        const char *message = cfg_err_message(cfg_);
+        return message ? std::string_view(message) : std::string_view();
+    }
+
+    // Global context
+    Node root() const noexcept { return cfg_ ? Node(cfg_global_context(cfg_)) : Node(); }
+
+    Node operator[](std::string_view name) const noexcept { return root()[name]; }
+    Node operator[](Key key) const noexcept { return root()[key]; }
+
+    template <typename T>
+    std::optional<T> get(std::string_view name) const noexcept { return root().get<T>(name); }
+    template <typename T>
+    std::optional<T> get(Key key) const noexcept { return root().get<T>(key); }
+
+private:
+    Cfg_Config *cfg_ = nullptr;
+};
+
+#ifdef CFG_HPP_ASYNC
+// Asynchronous loading, needs CFG_HPP_ASYNC
+//
+// `co_await cfg::async_load(executor, path)` reads and parses the file on the
+// executor and resumes the awaiting coroutine there with the loaded Config
+// (check `error()` of it). Executor is any type with `execute(std::function<void()>)`,
+// cfg::ThreadPool is a simple one.
+
+template <typename E>
+concept Executor = requires(E &executor, std::function<void()> task) { executor.execute(std::move(task)); };
+
+// Fixed number of worker threads sharing one FIFO queue of tasks
+// Destructor runs the queued tasks and joins the threads
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency())
+    {
+        if (threads == 0) threads = 1;
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) workers_.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (std::thread &worker : workers_) worker.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void execute(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cond_.notify_one();
+    }
+
+    std::size_t size() const noexcept { return workers_.size(); }
+
+private:
+    void work()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    bool stop_ = false;
+};
+
+// Pool used by `async_load(path)`, started on first use
+inline ThreadPool &default_executor()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+namespace detail {
+
+// Read whole regular file with pread into zero-terminated buffer
+// Returns false if it can not, caller falls back to cfg_load_file
+inline bool read_file(const char *path, std::vector<char> &buf)
+{
+#ifdef CFG_HPP_PREAD
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool ok = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (ok) {
+        std::size_t size = static_cast<std::size_t>(st.st_size);
+        std::size_t done = 0;
+        buf.resize(size + 1);
+        while (done < size) {
+            ssize_t len = ::pread(fd, buf.data() + done, size - done, static_cast<off_t>(done));
+            if (len < 0 && errno == EINTR) continue;
+            if (len <= 0) break;
+            done += static_cast<std::size_t>(len);
+        }
+        ok = done == size;
+        buf[done] = '\0';
+    }
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    (void)buf;
+    return false;
+#endif
+}
+
+inline Config load_file(const char *path)
+{
+    Config config;
+    if (!config) return config;
+
+    std::vector<char> buf;
+    if (read_file(path, buf)) {
+        config.load_buffer(buf.data(), path);
+    } else {
+        config.load_file(path);
+    }
+    return config;
+}
+
+} // namespace detail
+
+// Awaitable returned by `async_load`, must be awaited once
+template <Executor E>
+class LoadAwaitable {
+public:
+    LoadAwaitable(E &executor, std::string path) : executor_(executor), path_(std::move(path)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        executor_.execute([this, handle] {
+            result_ = detail::load_file(path_.c_str());
+            handle.resume();
+        });
+    }
+
+    Config await_resume() noexcept { return std::move(result_); }
+
+private:
+    E &executor_;
+    std::string path_;
+    Config result_{nullptr};
+};
+
+template <Executor E>
+LoadAwaitable<E> async_load(E &executor, std::string path)
+{
+    return LoadAwaitable<E>(executor, std::move(path));
+}
+
+inline LoadAwaitable<ThreadPool> async_load(std::string path)
+{
+    return LoadAwaitable<ThreadPool>(default_executor(), std::move(path));
+}
+#endif // CFG_HPP_ASYNC
+
+// Struct binding
+//
+// Fields of a struct and names of their variables are described once at global scope:
+//
+//     struct Endpoint { std::string host; int port = 80; };
+//     struct Settings { int workers = 1; std::vector<int> ports; Endpoint primary; };
+//     CFG_BIND(Endpoint, CFG_FIELD(host), CFG_FIELD(port))
+//     CFG_BIND(Settings, CFG_FIELD(workers), CFG_FIELD_AS(ports, "listen_ports"), CFG_FIELD(primary))
+//
+// `cfg::load<Settings>("app.cfg")` then parses the file straight into Settings,
+// no Cfg_Variable tree is built. Field types: int, double, bool, std::string,
+// bound structs, std::vector<T> (array or list) and std::array<T, N> (array or
+// list of exactly N elements). Variables without a field are skipped, fields
+// without a variable keep their default values. `@include` is not supported by
+// binding (nor by `embed` and `valid`) and fails with CFG_ERROR_INCLUDE, load
+// split configs through Config.
+
+// Error of binding, line and column point to the start of the offending token
+struct Error {
+    Cfg_Error_Type type = CFG_ERROR_NONE;
+    std::size_t line = 0;
+    std::size_t column = 0;
+};
+
+template <typename T>
+struct Binding;
+
+template <typename C, typename M>
+struct Field {
+    std::string_view name;
+    std::uint32_t hash;
+    M C::*member;
+};
+
+template <typename C, typename M>
+constexpr Field<C, M> field(std::string_view name, M C::*member) noexcept
+{
+    return {name, cfg::hash(name), member};
+}
+
+template <typename T>
+concept Bound = requires { Binding<T>::fields; };
+
+namespace detail {
+
+// Recursive descent reader of cfg syntax over a string
+class Reader {
+public:
+    enum class Word { None, Int, Double, Bool, Identifier };
+
+    constexpr explicit Reader(std::string_view src) noexcept : src_(src) {}
+
+    // Next character after spaces and comments, '\0' at the end
+    constexpr char peek() noexcept
+    {
+        skip();
+        return pos_ < src_.size() ? src_[pos_] : '\0';
+    }
+
+    constexpr bool eat(char ch) noexcept
+    {
+        if (peek() != ch || pos_ >= src_.size()) return false;
+        pos_++;
+        return true;
+    }
+
+    constexpr bool expect(char ch) noexcept
+    {
+        return eat(ch) || fail(CFG_ERROR_UNEXPECTED_TOKEN);
+    }
+
+    constexpr bool at_end() noexcept { return peek() == '\0'; }
+
+    // Identifier, bool or number, delimited like in the tokenizer of cfg.h
+    constexpr std::string_view word() noexcept
+    {
+        skip();
+        std::size_t start = pos_;
+        while (pos_ < src_.size() && !is_delimiter(src_[pos_])) pos_++;
+        return src_.substr(start, pos_ - start);
+    }
+
+    static constexpr Word classify(std::string_view word) noexcept
+    {
+        if (word.empty()) return Word::None;
+        if (word == "true" || word == "false") return Word::Bool;
+        if (word[0] < '0' || word[0] > '9') return Word::Identifier;
+
+        std::size_t dots = 0;
+        for (char ch : word) {
+            if (ch == '.') {
+                dots++;
+            } else if (ch < '0' || ch > '9') {
+                return Word::None;
+            }
+        }
+        if (dots > 1) return Word::None;
+        return dots == 0 ? Word::Int : Word::Double;
+    }
+
+    // Quoted string, adjacent strings are concatenated
+    // Unescaped characters are appended to `out` with `+=`
+    template <typename Out>
+    constexpr bool string(Out &out)
+    {
+        if (peek() != '"') return fail(CFG_ERROR_VARIABLE_WRONG_TYPE);
+        while (peek() == '"') {
+            pos_++;
+            bool backslash = false;
+            while (true) {
+                if (pos_ >= src_.size()) return fail(CFG_ERROR_UNEXPECTED_TOKEN);
+                char ch = src_[pos_++];
+                if (backslash) {
+                    switch (ch) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case '"': out += '"'; break;
+                    case '\'': out += '\''; break;
+                    case '\\': out += '\\'; break;
+                    default:
+                        out += '\\';
+                        out += ch;
+                        break;
+                    }
+                    backslash = false;
+                } else if (ch == '\\') {
+                    backslash = true;
+                } else if (ch == '"') {
+                    break;
+                } else {
+                    out += ch;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Quoted string without escapes, points into the source
+    constexpr bool string_view(std::string_view &out) noexcept
+    {
+        if (peek() != '"') return fail(CFG_ERROR_VARIABLE_WRONG_TYPE);
+        std::size_t start = pos_ + 1;
+        std::size_t end = src_.find_first_of("\"\\", start);
+        if (end == std::string_view::npos) return fail(CFG_ERROR_UNEXPECTED_TOKEN);
+        // Escapes and concatenation need a copy, bind to std::string instead
+        if (src_[end] == '\\') return fail(CFG_ERROR_VARIABLE_PARSE);
+        pos_ = end + 1;
+        if (peek() == '"') return fail(CFG_ERROR_VARIABLE_PARSE);
+        out = src_.substr(start, end - start);
+        return true;
+    }
+
+    // Record the first error, always returns false
+    constexpr bool fail(Cfg_Error_Type type) noexcept
+    {
+        if (error_.type != CFG_ERROR_NONE) return false;
+
+        error_.type = type;
+        error_.line = 1;
+        error_.column = 1;
+        for (std::size_t i = 0; i < mark_ && i < src_.size(); ++i) {
+            if (src_[i] == '\n') {
+                error_.line++;
+                error_.column = 1;
+            } else {
+                error_.column++;
+            }
+        }
+        return false;
+    }
+
+    constexpr const Error &error() const noexcept { return error_; }
+
+private:
+    static constexpr bool is_delimiter(char ch) noexcept
+    {
+        switch (ch) {
+        case ' ': case '\n': case '\t': case '\r': case '=': case ';': case ',':
+        case '[': case ']': case '(': case ')': case '{': case '}': case '"':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Skip spaces and comments, start of the next token is remembered for errors
+    constexpr void skip() noexcept
+    {
+        while (pos_ < src_.size()) {
+            char ch = src_[pos_];
+            char next = pos_ + 1 < src_.size() ? src_[pos_ + 1] : '\0';
+            if (ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r') {
+                pos_++;
+            } else if (ch == '/' && next == '/') {
+                while (pos_ < src_.size() && src_[pos_] != '\n') pos_++;
+            } else if (ch == '/' && next == '*') {
+                std::size_t end = src_.find("*/", pos_ + 2);
+                pos_ = end == std::string_view::npos ? src_.size() : end + 2;
+            } else {
+                break;
+            }
+        }
+        mark_ = pos_;
+    }
+
+    std::string_view src_;
+    std::size_t pos_ = 0;
+    std::size_t mark_ = 0;
+    Error error_;
+};
+
+// Appends nothing, used to skip strings
+struct Discard {
+    constexpr Discard &operator+=(char) noexcept { return *this; }
+};
+
+constexpr bool skip_value(Reader &r, Cfg_Type &type);
+
+// Variables `name = value;` until `close` ('\0' is the end of input)
+// Names must be unique in every struct, like in the parser of cfg.h
+constexpr bool skip_fields(Reader &r, char close)
+{
+    std::vector<std::string_view> names;
+    while (close == '\0' ? !r.at_end() : !r.eat(close)) {
+        std::string_view name = r.word();
+        if (name == "@include") return r.fail(CFG_ERROR_INCLUDE);
+        if (Reader::classify(name) != Reader::Word::Identifier) return r.fail(CFG_ERROR_UNEXPECTED_TOKEN);
+        for (std::string_view seen : names) {
+            if (seen == name) return r.fail(CFG_ERROR_VARIABLE_REDEFINITION);
+        }
+        names.push_back(name);
+        Cfg_Type type = CFG_TYPE_NONE;
+        if (!r.expect('=') || !skip_value(r, type) || !r.expect(';')) return false;
+    }
+    return true;
+}
+
+// Value of any type, for variables without a field
+// Elements of array must have the type of the first one, list elements may differ
+constexpr bool skip_value(Reader &r, Cfg_Type &type)
+{
+    char ch = r.peek();
+    if (ch == '"') {
+        Discard discard;
+        type = CFG_TYPE_STRING;
+        return r.string(discard);
+    }
+    if (ch == '[' || ch == '(') {
+        char close = ch == '[' ? ']' : ')';
+        type = ch == '[' ? CFG_TYPE_ARRAY : CFG_TYPE_LIST;
+        r.eat(ch);
+        Cfg_Type first = CFG_TYPE_NONE;
+        while (!r.eat(close)) {
+            Cfg_Type elem = CFG_TYPE_NONE;
+            if (!skip_value(r, elem)) return false;
+            if (first == CFG_TYPE_NONE) first = elem;
+            if (close == ']' && elem != first) return r.fail(CFG_ERROR_UNEXPECTED_TOKEN);
+            if (!r.eat(',')) return r.expect(close);
+        }
+        return true;
+    }
+    if (ch == '{') {
+        r.eat('{');
+        type = CFG_TYPE_STRUCT;
+        return skip_fields(r, '}');
+    }
+
+    switch (Reader::classify(r.word())) {
+    case Reader::Word::Int:
+        type = CFG_TYPE_INT;
+        return true;
+    case Reader::Word::Double:
+        type = CFG_TYPE_DOUBLE;
+        return true;
+    case Reader::Word::Bool:
+        type = CFG_TYPE_BOOL;
+        return true;
+    default:
+        return r.fail(CFG_ERROR_UNEXPECTED_TOKEN);
+    }
+}
+
+// Opening bracket of array or list, returns closing one or '\0' on error
+constexpr char open_sequence(Reader &r)
+{
+    if (r.eat('[')) return ']';
+    if (r.eat('(')) return ')';
+    r.fail(CFG_ERROR_VARIABLE_WRONG_TYPE);
+    return '\0';
+}
+
+} // namespace detail
+
+// Parser of field values, specialize it to bind other types
+// `parse` returns false and records error in reader on failure
+template <typename T>
+struct Parser {
+    static_assert(sizeof(T) == 0, "cfg: no Parser for this type, bind it with CFG_BIND");
+};
+
+template <>
+struct Parser<int> {
+    static constexpr bool parse(detail::Reader &r, int &out)
+    {
+        std::string_view word = r.word();
+        if (detail::Reader::classify(word) != detail::Reader::Word::Int) {
+            return r.fail(CFG_ERROR_VARIABLE_WRONG_TYPE);
+        }
+
+        long long res = 0;
+        for (char ch : word) {
+            res = res * 10 + (ch - '0');
+            if (res > INT32_MAX) return r.fail(CFG_ERROR_VARIABLE_PARSE);
+        }
+        out = static_cast<int>(res);
+        return true;
+    }
+};
+
+template <>
+struct Parser<double> {
+    static constexpr bool parse(detail::Reader &r, double &out)
+    {
+        std::string_view word = r.word();
+        if (detail::Reader::classify(word) != detail::Reader::Word::Double) {
+            return r.fail(CFG_ERROR_VARIABLE_WRONG_TYPE);
+        }
+
+        if (std::is_constant_evaluated()) {
+            out = constant(word);
+            return true;
+        }
+        auto [end, err] = std::from_chars(word.data(), word.data() + word.size(), out);
+        return err == std::errc() || r.fail(CFG_ERROR_VARIABLE_PARSE);
+    }
+
+private:
+    // std::from_chars is not constexpr. Exact while digits fit into 2^53 and the
+    // fraction into 10^22, otherwise rounding may differ in the last bits
+    static constexpr double constant(std::string_view word) noexcept
+    {
+        double mantissa = 0.0;
+        double scale = 1.0;
+        bool fraction = false;
+        for (char ch : word) {
+            if (ch == '.') {
+                fraction = true;
+                continue;
+            }
+            mantissa = mantissa * 10.0 + (ch - '0');
+            if (fraction) scale *= 10.0;
+        }
+        return mantissa / scale;
+    }
+};
+
+template <>
+struct Parser<bool> {
+    static constexpr bool parse(detail::Reader &r, bool &out)
+    {
+        std::string_view word = r.word();
+        if (detail::Reader::classify(word) != detail::Reader::Word::Bool) {
+            return r.fail(CFG_ERROR_VARIABLE_WRONG_TYPE);
+        }
+
+        out = word == "true";
+        return true;
+    }
+};
+
+template <typename Traits, typename A>
+struct Parser<std::basic_string<char, Traits, A>> {
+    static constexpr bool parse(detail::Reader &r, std::basic_string<char, Traits, A> &out)
+    {
+        out.clear();
+        return r.string(out);
+    }
+};
+
+// Points into the parsed text, which must outlive the value
+template <>
+struct Parser<std::string_view> {
+    static constexpr bool parse(detail::Reader &r, std::string_view &out)
+    {
+        return r.string_view(out);
+    }
+};
+
+template <typename T, typename A>
+struct Parser<std::vector<T, A>> {
+    static constexpr bool parse(detail::Reader &r, std::vector<T, A> &out)
+    {
+        char close = detail::open_sequence(r);
+        if (close == '\0') return false;
+
+        out.clear();
+        while (!r.eat(close)) {
+            T &item = out.emplace_back();
+            if (!Parser<T>::parse(r, item)) return false;
+            if (!r.eat(',')) return r.expect(close);
+        }
+        return true;
+    }
+};
+
+template <typename T, std::size_t N>
+struct Parser<std::array<T, N>> {
+    static constexpr bool parse(detail::Reader &r, std::array<T, N> &out)
+    {
+        char close = detail::open_sequence(r);
+        if (close == '\0') return false;
+
+        std::size_t len = 0;
+        while (!r.eat(close)) {
+            if (len == N) return r.fail(CFG_ERROR_VARIABLE_PARSE);
+            if (!Parser<T>::parse(r, out[len++])) return false;
+            if (!r.eat(',')) {
+                if (!r.expect(close)) return false;
+                break;
+            }
+        }
+        return len == N || r.fail(CFG_ERROR_VARIABLE_PARSE);
+    }
+};
+
+namespace detail {
+
+template <typename T>
+inline constexpr std::size_t fields_count = std::tuple_size_v<std::remove_cvref_t<decltype(Binding<T>::fields)>>;
+
+// Parse value into field with matching name, `matched` is false if there is none
+template <typename T, std::size_t I = 0>
+constexpr bool parse_field(Reader &r, T &out, std::string_view name, std::uint32_t hash,
+                           std::array<bool, fields_count<T>> &seen, bool &matched)
+{
+    if constexpr (I == fields_count<T>) {
+        return true;
+    } else {
+        constexpr auto field = std::get<I>(Binding<T>::fields);
+        if (field.hash == hash && field.name == name) {
+            matched = true;
+            if (seen[I]) return r.fail(CFG_ERROR_VARIABLE_REDEFINITION);
+            seen[I] = true;
+            using Member = std::remove_cvref_t<decltype(out.*field.member)>;
+            return Parser<Member>::parse(r, out.*field.member);
+        }
+        return parse_field<T, I + 1>(r, out, name, hash, seen, matched);
+    }
+}
+
+// Variables `name = value;` of bound struct until `close` ('\0' is the end of input)
+template <Bound T>
+constexpr bool parse_fields(Reader &r, T &out, char close)
+{
+    std::array<bool, fields_count<T>> seen{};
+    while (close == '\0' ? !r.at_end() : !r.eat(close)) {
+        std::string_view name = r.word();
+        if (name == "@include") return r.fail(CFG_ERROR_INCLUDE);
+        if (Reader::classify(name) != Reader::Word::Identifier) return r.fail(CFG_ERROR_UNEXPECTED_TOKEN);
+        if (!r.expect('=')) return false;
+
+        bool matched = false;
+        if (!parse_field(r, out, name, cfg::hash(name), seen, matched)) return false;
+        Cfg_Type type = CFG_TYPE_NONE;
+        if (!matched && !skip_value(r, type)) return false;
+        if (!r.expect(';')) return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+template <Bound T>
+struct Parser<T> {
+    static constexpr bool parse(detail::Reader &r, T &out)
+    {
+        if (!r.eat('{')) return r.fail(CFG_ERROR_VARIABLE_WRONG_TYPE);
+        return detail::parse_fields(r, out, '}');
+    }
+};
+
+// Parse config text into bound struct, fields without variables are left untouched
+// Returns false on error, see `error`
+template <Bound T>
+constexpr bool parse(std::string_view src, T &out, Error *error = nullptr)
+{
+    detail::Reader r(src);
+    bool ok = detail::parse_fields(r, out, '\0');
+    if (error) *error = r.error();
+    return ok;
+}
+
+namespace detail {
+
+// Not constexpr: reaching it during constant evaluation is a compile error
+inline void invalid_embedded_config(Cfg_Error_Type, std::size_t, std::size_t) noexcept {}
+
+} // namespace detail
+
+// Parse config literal into bound struct at compile time, errors fail the build
+//
+//     struct Defaults { int workers = 1; std::string_view host; std::array<int, 2> ports{}; };
+//     CFG_BIND(Defaults, CFG_FIELD(workers), CFG_FIELD(host), CFG_FIELD(ports))
+//     constexpr Defaults defaults = cfg::embed<Defaults>("workers = 4; host = \"localhost\"; ports = [80, 443];");
+//
+// The result must be a literal type: use std::string_view instead of std::string
+// and std::array instead of std::vector.
+template <Bound T>
+consteval T embed(std::string_view src)
+{
+    T out{};
+    Error error;
+    if (!parse(src, out, &error)) detail::invalid_embedded_config(error.type, error.line, error.column);
+    return out;
+}
+
+// Check config literal at compile time, for defaults loaded through Cfg_Config
+// Rules of cfg_load_buffer apply: syntax, one element type per array, unique names per struct.
+// Files can not be read at compile time, so text with `@include` is not valid
+//
+//     static constexpr char defaults[] = "workers = 4;";
+//     static_assert(cfg::valid(defaults));
+consteval bool valid(std::string_view src)
+{
+    detail::Reader r(src);
+    return detail::skip_fields(r, '\0');
+}
+
+// Load bound struct from config text/file, std::nullopt on error
+template <Bound T>
+std::optional<T> load_buffer(std::string_view src, Error *error = nullptr)
+{
+    T out{};
+    if (!parse(src, out, error)) return std::nullopt;
+    return out;
+}
+
+template <Bound T>
+std::optional<T> load(const char *path, Error *error = nullptr)
+{
+    std::string src;
+    std::FILE *file = std::fopen(path, "rb");
+    if (file) {
+        char chunk[4096];
+        std::size_t len;
+        while ((len = std::fread(chunk, 1, sizeof(chunk), file)) > 0) src.append(chunk, len);
+        std::fclose(file);
+    } else {
+        if (error) *error = Error{CFG_ERROR_OPEN_FILE, 0, 0};
+        return std::nullopt;
+    }
+    return load_buffer<T>(src, error);
+}
+
+namespace literals {
+
+// Key hashed at compile time: config["structure"_k]["nested"_k]
+consteval Key operator""_k(const char *name, std::size_t len)
+{
+    return Key(std::string_view(name, len));
+}
+
+} // namespace literals
+
+} // namespace cfg
+
+// Binding of struct fields, see "Struct binding" above
+// Must be used at global scope
+#define CFG_FIELD(member) ::cfg::field(#member, &cfg_bound_type::member)
+#define CFG_FIELD_AS(member, name) ::cfg::field(name, &cfg_bound_type::member)
+#define CFG_BIND(type, ...)                                          \
+    template <>                                                      \
+    struct cfg::Binding<type> {                                      \
+        using cfg_bound_type = type;                                 \
+        static constexpr auto fields = std::make_tuple(__VA_ARGS__); \
+    };
+
+#endif // CFG_HPP_